@@ -5,66 +5,356 @@
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/time.h>
 #include <time.h>
 #include <stdbool.h>
 #include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
+#include <signal.h>
 
-#define ERR_USAGE "Usage: <number_of_philosophers(int)> <time_to_die(int)> <time_to_eat(int)> <time_to_sleep(int)> [(optional)number_of_times_each_philosopher_must_eat(int)]"
+#define ERR_USAGE "Usage: <number_of_philosophers> <time_to_die> <time_to_eat> <time_to_sleep> [number_of_times_each_philosopher_must_eat] [key=value ...]\n\
+Durations are milliseconds unless suffixed with us, ms or s (e.g. 200, 0.5ms, 250us, 2s).\n\
+Options: poll=<duration> buffer=<bytes> stack=<bytes> control=<file> checkpoint=<file>\n\
+         checkpoint_every=<duration> restore=<file> record=<file> replay=<file>\n\
+         output=full|deaths|snapshot:<duration>|sample:<n> mode=thread|process procs=<n>"
+
+#define OUT_BUF_SIZE 65536
+#define OUT_LINE_MAX 64
+
+#define CONTROL_LINE_MAX 256
+
+/*
+ * Simulation parameters read by the hot paths. A build made with
+ * SPEC="<philos> <die> <eat> <sleep>" defines FIXED_CONFIG and the FIXED_*
+ * values (milliseconds), turning them into constants so the compiler folds
+ * the arithmetic and drops the branches on zero durations and the lone
+ * philosopher; the generic build reads them from the table. Such a build
+ * refuses seating changes, so SEATED() also makes the length of every
+ * seating a constant and the monitor's loops over it fixed-trip.
+ */
+#ifdef FIXED_CONFIG
+#define FIXED_US(ms) ((time_t)(ms) * 1000)
+#define NUM_PHILOS(table) (FIXED_NUM_PHILOS)
+#define SEATED(seating) (FIXED_NUM_PHILOS)
+#define TIME_TO_DIE(table) FIXED_US(FIXED_TIME_TO_DIE)
+#define TIME_TO_EAT(table) FIXED_US(FIXED_TIME_TO_EAT)
+#define TIME_TO_SLEEP(table) FIXED_US(FIXED_TIME_TO_SLEEP)
+#else
+#define NUM_PHILOS(table) ((table)->num_philos)
+#define SEATED(seating) ((seating)->num_philos)
+#define TIME_TO_DIE(table) ((table)->time_to_die)
+#define TIME_TO_EAT(table) ((table)->time_to_eat)
+#define TIME_TO_SLEEP(table) ((table)->time_to_sleep)
+#endif
 
 typedef struct s_philo t_philo;
+typedef struct s_table t_table;
+
+typedef enum e_status
+{
+    GOT_RIGHT_FORK,     //0
+    GOT_LEFT_FORK,      //1
+    EATING,             //2
+    SLEEPING,           //3
+    THINKING,           //4
+    DIED,               //5
+    JOINED,             //6
+    LEFT,               //7
+    STATUS_COUNT        //8
+} STATUS;
+
+/* How much of the status stream reaches stdout */
+typedef enum e_output
+{
+    OUT_FULL,           //0
+    OUT_DEATHS,         //1
+    OUT_SNAPSHOT,       //2
+    OUT_SAMPLE          //3
+} OUTPUT;
+
+/* Everything parsed from the command line; durations in microseconds */
+typedef struct s_config
+{
+    int     num_philos;
+    time_t  time_to_die;
+    time_t  time_to_eat;
+    time_t  time_to_sleep;
+    long    min_dining;
+    time_t  poll_interval;
+    size_t  out_buffer;
+    size_t  stack_size;
+    char    *control_path;
+    char    *checkpoint_path;
+    time_t  checkpoint_interval;
+    char    *restore_path;
+    char    *record_path;
+    char    *replay_path;
+    OUTPUT  output;
+    time_t  snapshot_interval;
+    long    sample_every;
+    bool    process_mode;
+    int     procs;
+} t_config;
+
+/* Philosopher IDs a fork was granted to, in order */
+typedef struct s_grant_log
+{
+    int     *ids;
+    int     len;
+    int     cap;
+} t_grant_log;
+
+/* A fork, allocated on its own so it can be re-linked between seatings */
+typedef struct s_fork
+{
+    int             id;
+    pthread_mutex_t lock;
+    t_table         *table;
+    t_grant_log     record;
+    bool            record_truncated;
+    t_grant_log     replay;
+    int             replay_pos;
+} t_fork;
+
+/* The pair of forks a philosopher uses, replaced whenever a neighbour changes */
+typedef struct s_seat
+{
+    t_fork  *fork[2];
+} t_seat;
+
+/* Immutable ring snapshot: philos[i] eats with forks[i] and forks[i + 1] */
+typedef struct s_seating
+{
+    int     num_philos;
+    t_philo **philos;
+    t_fork  **forks;
+} t_seating;
+
+/* Epoch a thread entered while it may hold seating pointers, 0 when quiescent */
+typedef struct s_epoch_slot
+{
+    unsigned long   epoch;
+    int             depth;
+} t_epoch_slot;
+
+/* Object unlinked from the seating, freed once no thread can still see it */
+typedef struct s_retired
+{
+    unsigned long       epoch;
+    time_t              retired_at;
+    void                *ptr;
+    void                (*destroy)(void *);
+    struct s_retired    *next;
+} t_retired;
+
+typedef struct s_seating_stats
+{
+    int         joins;
+    int         leaves;
+    long long   publish_us;
+    long long   drain_us;
+    int         reclaimed;
+    long long   grace_ms;
+} t_seating_stats;
+
+/* Time left before starving, sampled each time a meal starts */
+typedef struct s_slack
+{
+    long    count;
+    time_t  min;
+    time_t  sum;
+} t_slack;
+
+typedef struct s_ckpt_stats
+{
+    int     count;
+    time_t  pause_max_us;
+} t_ckpt_stats;
+
+#ifdef PROFILE
+#define PROF_SUB_BITS 3
+#define PROF_SUB_COUNT (1 << PROF_SUB_BITS)
+#define PROF_BUCKETS ((64 - PROF_SUB_BITS + 1) * PROF_SUB_COUNT)
+
+typedef enum e_phase
+{
+    PH_FORK_0,          //0
+    PH_FORK_1,          //1
+    PH_OVERSLEEP,       //2
+    PH_WRITE_LOCK,      //3
+    PH_COUNT            //4
+} PHASE;
+
+typedef struct s_histogram
+{
+    long long   count;
+    long long   sum;
+    long long   max;
+    long long   buckets[PROF_BUCKETS];
+} t_histogram;
+
+typedef struct s_profile
+{
+    t_histogram phase[PH_COUNT];
+} t_profile;
+
+#define PROF_BEGIN(t) long long t = profNow()
+#define PROF_END(phase, t) profRecord(phase, profNow() - (t))
+#define PROF_RECORD(phase, ns) profRecord(phase, ns)
+#define PROF_BIND(prof) profBind(prof)
+#define PROF_REPORT(table) profReport(table)
+#else
+#define PROF_BEGIN(t)
+#define PROF_END(phase, t)
+#define PROF_RECORD(phase, ns)
+#define PROF_BIND(prof)
+#define PROF_REPORT(table)
+#endif
 
 typedef struct s_table
 {
     int     num_philos;
     time_t  start_time;
-    int     time_to_die;
-    int     time_to_eat;
-    int     time_to_sleep;
+    time_t  launch_time;
+    time_t  resume_elapsed;
+    bool    restored;
+    time_t  time_to_die;
+    time_t  time_to_eat;
+    time_t  time_to_sleep;
+    time_t  poll_interval;
+    size_t  stack_size;
+    int     procs;
+    pid_t   *pids;
     pthread_t monitor;
-    pthread_mutex_t *fork_locks;
+    pthread_t controller;
+    char    *control_path;
+    t_seating   *seating;
+    int     next_id;
+    int     next_fork_id;
+    unsigned long   epoch;
+    t_epoch_slot    monitor_slot;
+    t_retired   *limbo;
+    t_seating_stats seating_stats;
+    char    *checkpoint_path;
+    time_t  checkpoint_interval;
+    t_ckpt_stats    ckpt_stats;
+    FILE    *record_file;
+    t_grant_log *replay_logs;
+    int     replay_count;
     pthread_mutex_t write_lock;
+    char    *out_buf;
+    size_t  out_len;
+    size_t  out_cap;
+    bool    out_line_flush;
+    OUTPUT  output;
+    time_t  snapshot_interval;
+    long    sample_every;
+    long    departed_events[STATUS_COUNT];
+    long    events_seen[STATUS_COUNT];
+    long    departed_meals;
+    t_slack departed_slack;
     pthread_mutex_t sim_stop_lock;
     bool    sim_stop;
-    int     min_dining;
-    t_philo **philos;
+    long    min_dining;
+#ifdef PROFILE
+    t_profile prof;
+#endif
 } t_table;
 
 typedef struct s_philo
 {
     int         id;
     pthread_t   thread;
-    int         fork[2];
-    int         times_ate;
+    t_seat      *seat;
+    bool        leaving;
+    bool        seated;
+    bool        eating;
+    t_epoch_slot    slot;
+    long        times_ate;
     time_t      last_meal;
+    t_slack     slack;
+    long        sample_tick;
+    long        *events;
     pthread_mutex_t meal_time_lock;
     t_table     *table;
+#ifdef PROFILE
+    t_profile   prof;
+#endif
 } t_philo;
 
-typedef enum e_status
-{
-    GOT_RIGHT_FORK,     //0
-    GOT_LEFT_FORK,      //1
-    EATING,             //2
-    SLEEPING,           //3
-    THINKING,           //4
-    DIED                //5
-} STATUS;
-
 int     msg(char *, int);
-bool    isValid(int, char **);
-t_table *initTable(int, char **);
+bool    parseArgs(int, char **, t_config *);
+bool    parseId(const char *, int *);
+bool    parseDuration(const char *, const char *, time_t *);
+t_table *initTable(t_config *);
+bool    spawnThread(t_table *, pthread_t *, void *(*)(void *), void *);
 void    *freeTableExit(t_table *);
 void    freeTable(t_table *);
 time_t  getTimeIn_ms(void);
+time_t  getTimeIn_us(void);
 bool    hasAnyoneDied(t_table *);
-void    lullPhilo(t_philo *, int);
+void    lullPhilo(t_philo *, time_t);
 void    simStartDelay(time_t);
 void    *philosopherRoutine(void *);
 void    writeStatus(t_philo *, STATUS);
+void    writeMessage(t_table *, char *);
+void    flushOutput(t_table *);
+void    writeSnapshot(t_table *);
+void    addSlack(t_slack *, time_t);
+void    mergeSlack(t_slack *, t_slack *);
+void    reportSummary(t_table *);
 void    *monitor(void *);
 bool    hasPhiloDied(t_philo *);
 bool    hasSimStopped(t_table *table);
+void    epochBind(t_epoch_slot *);
+void    epochEnter(t_table *);
+void    epochExit(void);
+void    epochRetire(t_table *, void *, void (*)(void *));
+void    epochAdvance(t_table *);
+void    epochReclaim(t_table *);
+void    drainLimbo(t_table *);
+t_fork  *createFork(t_table *);
+void    destroyFork(void *);
+t_philo *createPhilo(t_table *, t_fork *, t_fork *);
+void    destroyPhilo(void *);
+t_seating   *createSeating(int);
+void    destroySeating(void *);
+t_seating   *currentSeating(t_table *);
+bool    hasLeftTable(t_philo *);
+void    *seatingController(void *);
+void    reportSeatingStats(t_table *);
+bool    saveCheckpoint(t_table *, char *);
+bool    loadCheckpoint(t_table *, char *);
+int     checkpointSize(char *);
+void    reportCheckpointStats(t_table *);
+void    awaitGrantTurn(t_philo *, t_fork *);
+void    noteGrant(t_philo *, t_fork *);
+void    dumpGrants(t_fork *);
+void    attachReplay(t_table *, t_fork *);
+bool    loadReplay(t_table *, char *);
+void    freeReplay(t_table *);
+bool    openArena(int, size_t);
+void    closeArena(void);
+void    *sharedAlloc(size_t);
+void    sharedFree(void *);
+bool    initLock(pthread_mutex_t *);
+void    lockMutex(pthread_mutex_t *);
+bool    forkPhilosophers(t_table *);
+void    waitPhilosophers(t_table *);
+#ifdef PROFILE
+long long   profNow(void);
+void    profBind(t_profile *);
+void    profRecord(PHASE, long long);
+void    profMerge(t_profile *, t_profile *);
+void    profReport(t_table *);
+#endif
 
 
 #endif
\ No newline at end of file
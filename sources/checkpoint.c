@@ -0,0 +1,288 @@
+#include "philo.h"
+
+#define CKPT_MAGIC "PHCK"
+#define CKPT_VERSION 3
+
+typedef struct s_ckpt_header
+{
+    char        magic[4];
+    uint32_t    version;
+    int32_t     num_philos;
+    int32_t     next_id;
+    int32_t     sim_stop;
+    int32_t     reserved;
+    int64_t     time_to_die;
+    int64_t     time_to_eat;
+    int64_t     time_to_sleep;
+    int64_t     min_dining;
+    int64_t     elapsed_us;
+} t_ckpt_header;
+
+typedef struct s_ckpt_philo
+{
+    int32_t     id;
+    int32_t     eating;
+    int64_t     times_ate;
+    int64_t     last_meal_us;
+} t_ckpt_philo;
+
+
+/**
+ * @brief Capture the seating into a checkpoint image at a consistent point.
+ *
+ * Must run on the controller, the only thread that changes the seating.
+ * Every seated philosopher's meal_time_lock is taken in ring order, which
+ * freezes all meal counts, meal timestamps, eating flags and status output
+ * at once; the records are copied and the locks released. Philosophers are
+ * held up only for the time it takes to copy N small records.
+ *
+ * @param table Pointer to the simulation table.
+ * @param head Header to fill.
+ * @param recs Array with room for one record per seated philosopher.
+ * @return Time the philosophers were held, in microseconds.
+ */
+static time_t captureState(t_table *table, t_ckpt_header *head, t_ckpt_philo *recs)
+{
+    t_seating   *seating;
+    time_t      begin;
+    time_t      now;
+    int         i;
+
+    seating = table->seating;
+    // Read before taking meal locks: reportDeath() nests them the other way.
+    head->sim_stop = hasSimStopped(table);
+    begin = getTimeIn_us();
+    i = -1;
+    while (++i < seating->num_philos)
+        lockMutex(&seating->philos[i]->meal_time_lock);
+    now = getTimeIn_us();
+    i = -1;
+    while (++i < seating->num_philos)
+    {
+        recs[i].id = seating->philos[i]->id;
+        recs[i].times_ate = seating->philos[i]->times_ate;
+        recs[i].last_meal_us = seating->philos[i]->last_meal - table->start_time;
+        recs[i].eating = seating->philos[i]->eating;
+    }
+    i = seating->num_philos;
+    while (--i >= 0)
+        pthread_mutex_unlock(&seating->philos[i]->meal_time_lock);
+    memcpy(head->magic, CKPT_MAGIC, 4);
+    head->version = CKPT_VERSION;
+    head->num_philos = seating->num_philos;
+    head->time_to_die = table->time_to_die;
+    head->time_to_eat = table->time_to_eat;
+    head->time_to_sleep = table->time_to_sleep;
+    head->min_dining = table->min_dining;
+    head->next_id = table->next_id;
+    head->reserved = 0;
+    head->elapsed_us = now - table->start_time;
+    return getTimeIn_us() - begin;
+}
+
+
+/**
+ * @brief Write a byte range to a file descriptor, retrying on short writes.
+ *
+ * @param fd Destination.
+ * @param buf Bytes to write.
+ * @param len Number of bytes.
+ * @return true if everything was written.
+ */
+static bool writeFully(int fd, const void *buf, size_t len)
+{
+    ssize_t ret;
+
+    while (len > 0)
+    {
+        ret = write(fd, buf, len);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            return false;
+        buf = (const char *)buf + ret;
+        len -= ret;
+    }
+    return true;
+}
+
+
+/**
+ * @brief Snapshot the running simulation to a file.
+ *
+ * The state is captured in memory first (see captureState), then written
+ * to "<path>.tmp", synced and renamed over path, so a crash mid-write
+ * never destroys the previous checkpoint.
+ *
+ * @param table Pointer to the simulation table.
+ * @param path Destination file.
+ * @return true on success, false otherwise.
+ */
+bool saveCheckpoint(t_table *table, char *path)
+{
+    t_ckpt_header   head;
+    t_ckpt_philo    *recs;
+    char            tmp[PATH_MAX];
+    time_t          pause;
+    bool            ok;
+    int             fd;
+
+    recs = malloc(sizeof(t_ckpt_philo) * table->seating->num_philos);
+    if (!recs)
+        return false;
+    pause = captureState(table, &head, recs);
+    ok = snprintf(tmp, sizeof(tmp), "%s.tmp", path) < (int)sizeof(tmp);
+    fd = ok ? open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644) : -1;
+    ok = fd >= 0
+        && writeFully(fd, &head, sizeof(head))
+        && writeFully(fd, recs, sizeof(t_ckpt_philo) * head.num_philos)
+        && fsync(fd) == 0;
+    if (fd >= 0 && close(fd) != 0)
+        ok = false;
+    if (ok)
+        ok = rename(tmp, path) == 0;
+    free(recs);
+    if (!ok)
+        return false;
+    table->ckpt_stats.count ++;
+    if (pause > table->ckpt_stats.pause_max_us)
+        table->ckpt_stats.pause_max_us = pause;
+    return true;
+}
+
+
+/**
+ * @brief Read a byte range from a file descriptor, retrying on short reads.
+ *
+ * @param fd Source.
+ * @param buf Destination buffer.
+ * @param len Number of bytes.
+ * @return true if exactly len bytes were read.
+ */
+static bool readFully(int fd, void *buf, size_t len)
+{
+    ssize_t ret;
+
+    while (len > 0)
+    {
+        ret = read(fd, buf, len);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            return false;
+        buf = (char *)buf + ret;
+        len -= ret;
+    }
+    return true;
+}
+
+
+/**
+ * @brief Rebuild the seating from a checkpoint file.
+ *
+ * The timing parameters on the command line must match the checkpoint;
+ * the roster (count, IDs, meal counts and meal times) comes from the file.
+ * Each philosopher's last_meal is left relative to the simulation start
+ * and resolved by the simulator once the new start time is known.
+ * Philosophers that were eating (had stamped the meal with both forks
+ * held) finish that meal; the others think first in proportion to their
+ * remaining slack.
+ * A simulation that had already stopped is restored stopped.
+ *
+ * @param table Pointer to the simulation table, timing already parsed.
+ * @param path Checkpoint file.
+ * @return true on success, false otherwise (the message is printed).
+ */
+bool loadCheckpoint(t_table *table, char *path)
+{
+    t_ckpt_header   head;
+    t_ckpt_philo    *recs;
+    t_seating       *seating;
+    bool            ok;
+    int             fd;
+    int             n;
+    int             i;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return msg("Cannot open checkpoint file.", false);
+    recs = NULL;
+    ok = readFully(fd, &head, sizeof(head))
+        && memcmp(head.magic, CKPT_MAGIC, 4) == 0
+        && head.version == CKPT_VERSION
+        && head.num_philos >= 1;
+    if (ok)
+    {
+        recs = malloc(sizeof(t_ckpt_philo) * head.num_philos);
+        ok = recs && readFully(fd, recs, sizeof(t_ckpt_philo) * head.num_philos);
+    }
+    close(fd);
+    if (!ok)
+    {
+        free(recs);
+        return msg("Checkpoint file is corrupt or incomplete.", false);
+    }
+    if (head.time_to_die != table->time_to_die || head.time_to_eat != table->time_to_eat
+        || head.time_to_sleep != table->time_to_sleep || head.min_dining != table->min_dining)
+    {
+        free(recs);
+        return msg("Checkpoint does not match the given arguments.", false);
+    }
+    n = head.num_philos;
+    if (n != table->num_philos)
+    {
+        free(recs);
+        return msg("Checkpoint file changed while loading.", false);
+    }
+    seating = table->seating;
+    i = -1;
+    while (++i < n)
+    {
+        seating->philos[i]->id = recs[i].id;
+        seating->philos[i]->times_ate = recs[i].times_ate;
+        seating->philos[i]->last_meal = recs[i].last_meal_us;
+        seating->philos[i]->eating = recs[i].eating;
+    }
+    table->next_id = head.next_id;
+    table->resume_elapsed = head.elapsed_us;
+    table->sim_stop = head.sim_stop;
+    table->restored = true;
+    free(recs);
+    return true;
+}
+
+
+/**
+ * @brief Peek at the number of philosophers stored in a checkpoint.
+ *
+ * @param path Checkpoint file.
+ * @return Philosopher count, or -1 if the file cannot be read.
+ */
+int checkpointSize(char *path)
+{
+    t_ckpt_header   head;
+    bool            ok;
+    int             fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    ok = readFully(fd, &head, sizeof(head)) && memcmp(head.magic, CKPT_MAGIC, 4) == 0
+        && head.version == CKPT_VERSION;
+    close(fd);
+    if (!ok || head.num_philos < 1)
+        return -1;
+    return head.num_philos;
+}
+
+
+/**
+ * @brief Print how many checkpoints were taken and the longest pause.
+ *
+ * @param table Pointer to the simulation table.
+ */
+void reportCheckpointStats(t_table *table)
+{
+    printf("CHECKPOINT\tcount=%d\tpause_max_us=%ld\n",
+        table->ckpt_stats.count, (long)table->ckpt_stats.pause_max_us);
+}
@@ -0,0 +1,178 @@
+#include "philo.h"
+
+static __thread t_epoch_slot *g_slot = NULL;
+
+
+/**
+ * @brief Attach an epoch slot to the calling thread.
+ *
+ * Threads that never bind a slot (the main thread, the seating controller)
+ * are treated as writers and skip epoch bookkeeping entirely.
+ *
+ * @param slot Slot owned by the calling thread.
+ */
+void epochBind(t_epoch_slot *slot)
+{
+    g_slot = slot;
+}
+
+
+/**
+ * @brief Enter a read-side critical section on the seating.
+ *
+ * Publishes the current global epoch in the caller's slot before any seating
+ * pointer is loaded. Nested calls only bump a thread-private depth counter.
+ *
+ * @param table Pointer to the simulation table.
+ */
+void epochEnter(t_table *table)
+{
+    if (g_slot == NULL)
+        return;
+    if (g_slot->depth++ == 0)
+        __atomic_store_n(&g_slot->epoch,
+            __atomic_load_n(&table->epoch, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+}
+
+
+/**
+ * @brief Leave a read-side critical section on the seating.
+ *
+ * Once the outermost section is left the slot goes quiescent and no longer
+ * holds back reclamation.
+ */
+void epochExit(void)
+{
+    if (g_slot == NULL)
+        return;
+    if (--g_slot->depth == 0)
+        __atomic_store_n(&g_slot->epoch, 0, __ATOMIC_SEQ_CST);
+}
+
+
+/**
+ * @brief Queue an object that has been unlinked from the seating for freeing.
+ *
+ * The object is tagged with the current epoch; it is destroyed by
+ * epochReclaim() once every reader that may have seen it has moved on.
+ * Only the seating controller retires objects.
+ *
+ * @param table Pointer to the simulation table.
+ * @param ptr Object to free.
+ * @param destroy Function releasing the object.
+ */
+void epochRetire(t_table *table, void *ptr, void (*destroy)(void *))
+{
+    t_retired   *node;
+
+    node = malloc(sizeof(t_retired));
+    if (!node)
+    {
+        // Leaking is safer than freeing something a reader may still hold.
+        return;
+    }
+    node->epoch = __atomic_load_n(&table->epoch, __ATOMIC_SEQ_CST);
+    node->retired_at = getTimeIn_ms();
+    node->ptr = ptr;
+    node->destroy = destroy;
+    node->next = table->limbo;
+    table->limbo = node;
+}
+
+
+/**
+ * @brief Move the global epoch forward after publishing a new seating.
+ *
+ * @param table Pointer to the simulation table.
+ */
+void epochAdvance(t_table *table)
+{
+    __atomic_add_fetch(&table->epoch, 1, __ATOMIC_SEQ_CST);
+}
+
+
+/**
+ * @brief Lowest epoch any reader is currently inside, or ULONG_MAX if none.
+ *
+ * Scans the slots of every seated philosopher plus the monitor. Departed
+ * philosophers are joined before their retirement, so they need no scan.
+ *
+ * @param table Pointer to the simulation table.
+ * @return Oldest active epoch.
+ */
+static unsigned long oldestActiveEpoch(t_table *table)
+{
+    unsigned long   oldest;
+    unsigned long   e;
+    int             i;
+
+    oldest = __atomic_load_n(&table->monitor_slot.epoch, __ATOMIC_SEQ_CST);
+    if (oldest == 0)
+        oldest = (unsigned long)-1;
+    i = -1;
+    while (++i < table->seating->num_philos)
+    {
+        e = __atomic_load_n(&table->seating->philos[i]->slot.epoch,
+            __ATOMIC_SEQ_CST);
+        if (e != 0 && e < oldest)
+            oldest = e;
+    }
+    return oldest;
+}
+
+
+/**
+ * @brief Destroy every retired object no reader can still reference.
+ *
+ * An object retired in epoch E is safe once every active reader entered in
+ * an epoch later than E, since those readers loaded the seating after it
+ * was unlinked.
+ *
+ * @param table Pointer to the simulation table.
+ */
+void epochReclaim(t_table *table)
+{
+    unsigned long   oldest;
+    t_retired       **link;
+    t_retired       *node;
+
+    if (table->limbo == NULL)
+        return;
+    oldest = oldestActiveEpoch(table);
+    link = &table->limbo;
+    while (*link)
+    {
+        node = *link;
+        if (node->epoch < oldest)
+        {
+            *link = node->next;
+            table->seating_stats.reclaimed ++;
+            table->seating_stats.grace_ms += getTimeIn_ms() - node->retired_at;
+            node->destroy(node->ptr);
+            free(node);
+        }
+        else
+            link = &node->next;
+    }
+}
+
+
+/**
+ * @brief Destroy every retired object unconditionally.
+ *
+ * Only valid once all threads have been joined.
+ *
+ * @param table Pointer to the simulation table.
+ */
+void drainLimbo(t_table *table)
+{
+    t_retired   *node;
+
+    while (table->limbo)
+    {
+        node = table->limbo;
+        table->limbo = node->next;
+        node->destroy(node->ptr);
+        free(node);
+    }
+}
@@ -34,10 +34,12 @@ void *freeTableExit(t_table *table)
  * @brief Frees all dynamically allocated memory used in the simulation table.
  *
  * This function is responsible for cleaning up memory associated with:
- * - The array of fork mutexes.
- * - Each philosopher's structure.
- * - The array of philosopher pointers.
- * - The table structure itself.
+ * - Every seated philosopher and fork, along with their mutexes.
+ * - The current seating snapshot.
+ * - Everything still waiting for reclamation after a seating change.
+ * - The grant record file (flushed as forks are destroyed) and replay logs.
+ * - The output buffer.
+ * - The table structure itself, and the shared arena in process mode.
  *
  * It should be called at the end of the program or upon failure to prevent
  * memory leaks and ensure proper resource deallocation.
@@ -48,12 +50,22 @@ void freeTable(t_table *table)
 {
     int i;
 
-    free(table->fork_locks);
-    i = -1;
-    while (++i < table->num_philos)
+    if (table->seating)
     {
-        free(table->philos[i]);
+        i = -1;
+        while (++i < table->seating->num_philos)
+        {
+            destroyPhilo(table->seating->philos[i]);
+            destroyFork(table->seating->forks[i]);
+        }
+        destroySeating(table->seating);
     }
-    free(table->philos);
-    free(table);
-}
\ No newline at end of file
+    drainLimbo(table);
+    if (table->record_file)
+        fclose(table->record_file);
+    freeReplay(table);
+    sharedFree(table->out_buf);
+    free(table->pids);
+    sharedFree(table);
+    closeArena();
+}
@@ -1,79 +1,212 @@
 #include "philo.h"
 
 /**
- * @brief Allocates and initializes philosopher structures for the simulation.
+ * @brief Destroys the first forks and philosophers of a partial seating.
+ *
+ * @param seating Seating being built.
+ * @param forks Number of forks created so far.
+ * @param philos Number of philosophers created so far.
+ * @return Always returns NULL.
+ */
+static t_seating *abortSeating(t_seating *seating, int forks, int philos)
+{
+    while (--philos >= 0)
+        destroyPhilo(seating->philos[philos]);
+    while (--forks >= 0)
+        destroyFork(seating->forks[forks]);
+    destroySeating(seating);
+    return NULL;
+}
+
+
+/**
+ * @brief Builds the initial ring of forks and philosophers.
  * 
- * Allocates an array of philosopher pointers and then allocates each philosopher struct.
- * Sets philosopher ID, forks they use, times eaten, and a pointer to the shared table.
- * Returns NULL if any allocation fails.
+ * Allocates one fork per seat, then one philosopher per seat using forks i
+ * and i + 1 (wrapping around), and wraps them in the first seating snapshot.
+ * Destroys whatever was created and returns NULL if anything fails.
  *
  * @param table Pointer to the simulation table containing configuration.
- * @return Pointer to array of initialized philosopher pointers, or NULL on failure.
+ * @return Pointer to the initial seating, or NULL on failure.
  */
-static t_philo **initPhilos(t_table *table)
+static t_seating *initSeating(t_table *table)
 {
     int i;
-    t_philo    **philos;
+    t_seating   *seating;
 
-    philos = malloc(sizeof(t_philo *) * table->num_philos);
-    if (!philos)
+    seating = createSeating(table->num_philos);
+    if (!seating)
     {
         return NULL;
     }
     i = -1;
     while (++i <  table->num_philos)
     {
-        philos[i] = malloc(sizeof(t_philo));
-        if (!philos[i])
-            return NULL; 
-        philos[i]->id = i + 1;
-        philos[i]->fork[0] = i;
-        philos[i]->fork[1] = (i + 1) % table->num_philos;
-        philos[i]->times_ate = 0;
-        philos[i]->table = table;
+        seating->forks[i] = createFork(table);
+        if (!seating->forks[i])
+            return abortSeating(seating, i, 0);
+    }
+    i = -1;
+    while (++i <  table->num_philos)
+    {
+        seating->philos[i] = createPhilo(table, seating->forks[i],
+            seating->forks[(i + 1) % table->num_philos]);
+        if (!seating->philos[i])
+            return abortSeating(seating, table->num_philos, i);
+        seating->philos[i]->last_meal = 0;
+        seating->philos[i]->seated = true;
     }
-    return philos;
+    return seating;
+}
+
+
+/**
+ * @brief Creates a thread with the configured stack size.
+ *
+ * @param table Pointer to the simulation table holding the stack size (0 for the default).
+ * @param thread Receives the thread handle.
+ * @param routine Thread entry point.
+ * @param arg Argument passed to routine.
+ * @return true if the thread was created, false otherwise.
+ */
+bool spawnThread(t_table *table, pthread_t *thread, void *(*routine)(void *), void *arg)
+{
+    pthread_attr_t  attr;
+    bool            ok;
+
+    if (table->stack_size == 0)
+        return pthread_create(thread, NULL, routine, arg) == 0;
+    if (pthread_attr_init(&attr) != 0)
+        return false;
+    ok = pthread_attr_setstacksize(&attr, table->stack_size) == 0
+        && pthread_create(thread, &attr, routine, arg) == 0;
+    pthread_attr_destroy(&attr);
+    return ok;
 }
 
 
 /**
  * @brief Allocates and initializes the simulation table with parameters.
  * 
- * Parses command line arguments to set simulation settings,
- * allocates mutex array for forks, initializes philosophers,
- * and sets simulation stop flag to false.
+ * In process mode, first maps the shared arena that the table, seating and
+ * output buffer are allocated from, so forked philosopher processes see
+ * them. Copies the parsed configuration into the table, loads a replay schedule
+ * and opens the record file if requested, builds the initial seating (or
+ * restores it from a checkpoint) and the output buffer, and sets simulation
+ * stop flag to false.
  * Frees allocated memory and returns NULL on failure.
  * 
- * @param ac Argument count.
- * @param av Argument vector.
+ * @param cfg Parsed command-line configuration.
  * @return Pointer to initialized t_table struct, or NULL on failure.
  */
-t_table *initTable(int ac, char **av)
+t_table *initTable(t_config *cfg)
 {
     t_table *table;
+    int     n;
 
-    table = malloc(sizeof(t_table));
+    if (cfg->process_mode)
+    {
+        n = cfg->restore_path ? checkpointSize(cfg->restore_path) : cfg->num_philos;
+        if (!openArena(n < 1 ? cfg->num_philos : n, cfg->out_buffer))
+        {
+            msg("Cannot map shared memory.", 0);
+            return NULL;
+        }
+    }
+    table = sharedAlloc(sizeof(t_table));
     if (!table)
+    {
+        closeArena();
         return NULL;
-    table->num_philos = atoi(av[1]);
-    table->time_to_die = atoi(av[2]);
-    table->time_to_eat = atoi(av[3]);
-    table->time_to_sleep = atoi(av[4]);
-    if (ac == 6)
-        table->min_dining = atoi(av[5]);
-    else 
-        table->min_dining = -1;
-    table->fork_locks = malloc(sizeof(pthread_mutex_t) * table->num_philos);
-    if (!table->fork_locks)
+    }
+    table->out_buf = NULL;
+    table->pids = NULL;
+    table->seating = NULL;
+    table->limbo = NULL;
+    table->next_id = 1;
+    table->next_fork_id = 0;
+    table->resume_elapsed = 0;
+    table->restored = false;
+    table->sim_stop = false;
+    table->record_file = NULL;
+    table->replay_logs = NULL;
+    table->replay_count = 0;
+    table->departed_meals = 0;
+    memset(&table->departed_slack, 0, sizeof(t_slack));
+    table->num_philos = cfg->num_philos;
+    table->time_to_die = cfg->time_to_die;
+    table->time_to_eat = cfg->time_to_eat;
+    table->time_to_sleep = cfg->time_to_sleep;
+    table->min_dining = cfg->min_dining;
+    table->poll_interval = cfg->poll_interval;
+    table->stack_size = cfg->stack_size;
+    if (cfg->replay_path && !loadReplay(table, cfg->replay_path))
+    {
+        return freeTableExit(table);
+    }
+    if (cfg->record_path)
+    {
+        table->record_file = fopen(cfg->record_path, "w");
+        if (!table->record_file)
+        {
+            msg("Cannot open record file.", 0);
+            return freeTableExit(table);
+        }
+    }
+    if (cfg->restore_path)
+    {
+        table->num_philos = checkpointSize(cfg->restore_path);
+        if (table->num_philos < 1)
+        {
+            table->num_philos = 0;
+            msg("Cannot read checkpoint file.", 0);
+            return freeTableExit(table);
+        }
+#ifdef FIXED_CONFIG
+        if (table->num_philos != FIXED_NUM_PHILOS)
+        {
+            table->num_philos = 0;
+            msg("Checkpoint does not match the specialized build.", 0);
+            return freeTableExit(table);
+        }
+#endif
+    }
+    table->seating = initSeating(table);
+    if (table->seating == NULL)
     {
         return freeTableExit(table);
     }
-    table->philos = initPhilos(table);
-    if (table->philos == NULL)
+    if (cfg->restore_path && !loadCheckpoint(table, cfg->restore_path))
     {
         return freeTableExit(table);
     }
-    table->sim_stop = false;
+    table->out_buf = sharedAlloc(cfg->out_buffer);
+    if (!table->out_buf)
+    {
+        return freeTableExit(table);
+    }
+    table->out_len = 0;
+    table->out_cap = cfg->out_buffer;
+    table->out_line_flush = isatty(STDOUT_FILENO);
+    table->procs = 0;
+    if (cfg->process_mode)
+        table->procs = (cfg->procs && cfg->procs < table->num_philos) ? cfg->procs : table->num_philos;
+    table->output = cfg->output;
+    table->snapshot_interval = cfg->snapshot_interval;
+    table->sample_every = cfg->sample_every;
+    memset(table->departed_events, 0, sizeof(table->departed_events));
+    memset(table->events_seen, 0, sizeof(table->events_seen));
+    table->control_path = cfg->control_path;
+    table->checkpoint_path = cfg->checkpoint_path;
+    table->checkpoint_interval = cfg->checkpoint_interval;
+    memset(&table->ckpt_stats, 0, sizeof(t_ckpt_stats));
+    table->epoch = 1;
+    table->monitor_slot.epoch = 0;
+    table->monitor_slot.depth = 0;
+    memset(&table->seating_stats, 0, sizeof(t_seating_stats));
+#ifdef PROFILE
+    memset(&table->prof, 0, sizeof(t_profile));
+#endif
     
     return table;
-}
\ No newline at end of file
+}
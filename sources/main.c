@@ -14,66 +14,46 @@
 
 
 /**
- * @brief Destroys all previously initialized mutexes in the simulation.
+ * @brief Destroys the table-wide mutexes of the simulation.
  *
  * This function is responsible for properly releasing system resources 
  * allocated for mutexes during the simulation. It ensures that:
  * - The write lock (used for synchronized output) is destroyed.
  * - The simulation stop lock is destroyed.
- * - Each fork lock and each philosopher's meal time lock is destroyed.
  *
- * This function should be called after the simulation has ended to avoid
- * resource leaks and ensure a clean shutdown.
+ * Fork and meal time locks belong to their forks and philosophers and are
+ * destroyed together with them by `freeTable`.
  *
  * @param table A pointer to the simulation table structure containing all mutexes.
  */
 static void    destroyMutex(t_table *table)
 {
-    int i;
-
     pthread_mutex_destroy(&table->write_lock);
     pthread_mutex_destroy(&table->sim_stop_lock);
-    i = -1;
-    while (++ i < table->num_philos)
-    {
-        pthread_mutex_destroy(&table->fork_locks[i]);
-        pthread_mutex_destroy(&table->philos[i]->meal_time_lock);
-    }
 }
 
 
 /**
- * @brief Initializes all necessary mutexes for the simulation.
+ * @brief Initializes the table-wide mutexes for the simulation.
  *
  * This function sets up mutexes required for thread-safe operations:
  * - A write lock to synchronize console output among philosophers.
  * - A simulation stop lock to safely control and check simulation termination.
- * - A mutex for each fork to ensure mutual exclusion on fork access.
- * - A mutex for each philosopher's `last_meal` access to avoid race conditions
- *   when reading/writing the meal time across threads.
+ *
+ * Fork and meal time locks are initialized when the forks and philosophers
+ * are created, since philosophers can also join a running simulation.
  *
  * If any mutex fails to initialize, the function returns `false` to indicate failure.
- * Proper cleanup should be handled by the caller if this function fails part-way.
  *
  * @param table A pointer to the simulation table structure containing shared state.
  * @return `true` if all mutexes were successfully initialized, `false` otherwise.
  */
 static bool    initializeMutex(t_table *table)
 {
-    int i;
-
-    if (pthread_mutex_init(&table->write_lock, NULL) != 0)
+    if (!initLock(&table->write_lock))
         return false;
-    if (pthread_mutex_init(&table->sim_stop_lock, NULL) != 0)
+    if (!initLock(&table->sim_stop_lock))
         return false;
-    i = -1;
-    while (++ i < table->num_philos)
-    {
-        if (pthread_mutex_init(&table->fork_locks[i], NULL) != 0)
-            return false;
-        if (pthread_mutex_init(&table->philos[i]->meal_time_lock, NULL) != 0)
-            return false;
-    }
     return true;
 }
 
@@ -81,15 +61,23 @@ static bool    initializeMutex(t_table *table)
 /**
  * @brief Starts the philosopher simulation.
  *
- * This function initializes the simulation start time with a small offset 
+ * This function initializes the simulation launch time with a small offset 
  * based on the number of philosophers to reduce immediate thread contention.
+ * The start time, which timestamps are relative to, is set back by the
+ * elapsed time of a restored checkpoint.
  * It performs the following steps:
  * 
  * - Initializes all required mutexes.
- * - Sets the `last_meal` time for each philosopher.
- * - Creates a thread for each philosopher to execute their routine.
+ * - Resolves each philosopher's `last_meal`, kept relative to the start
+ *   time until now, into an absolute time.
+ * - Creates a thread for each philosopher to execute their routine, or in
+ *   process mode forks the philosopher processes, each running its group
+ *   of philosophers as threads. This happens before the parent starts any
+ *   thread of its own.
  * - If there is more than one philosopher, a monitor thread is also created
- *   to check for starvation or completion conditions.
+ *   to check for starvation or completion conditions, and, when a control
+ *   file or periodic checkpoints are configured, a seating controller
+ *   thread that lets philosophers join and leave and takes snapshots.
  *
  * If any thread fails to be created or mutex initialization fails, 
  * the function returns `false` indicating the simulation could not be started.
@@ -99,25 +87,46 @@ static bool    initializeMutex(t_table *table)
  */
 static bool    startSimulator(t_table *table)
 {
+    t_seating   *seating;
     int i;
 
-    table->start_time = getTimeIn_ms() + 20 * table->num_philos;
+    table->launch_time = getTimeIn_us() + 20000 * (time_t)table->num_philos;
+    table->start_time = table->launch_time - table->resume_elapsed;
 
     if (!initializeMutex(table))
         return false;
 
+    seating = table->seating;
     i = -1;
-    while (++i < table->num_philos)
+    while (++i < seating->num_philos)
+        seating->philos[i]->last_meal += table->start_time;
+    if (table->procs > 0)
     {
-        table->philos[i]->last_meal = table->start_time;
-        if (pthread_create(&table->philos[i]->thread, NULL, &philosopherRoutine, (void *)table->philos[i]) != 0)
+        if (!forkPhilosophers(table))
             return false;
     }
-    if (table->num_philos > 1)
+    else
     {
-        if (pthread_create(&table->monitor, NULL, &monitor, (void *)table) != 0)
+        i = -1;
+        while (++i < seating->num_philos)
+        {
+            if (!spawnThread(table, &seating->philos[i]->thread, &philosopherRoutine, (void *)seating->philos[i]))
+                return false;
+        }
+    }
+    if (NUM_PHILOS(table) > 1)
+    {
+        if (!spawnThread(table, &table->monitor, &monitor, (void *)table))
+            return false;
+        if ((table->control_path || table->checkpoint_path)
+            && !spawnThread(table, &table->controller, &seatingController, (void *)table))
             return false;
     }
+    else
+    {
+        table->control_path = NULL;
+        table->checkpoint_path = NULL;
+    }
 
     return true;
 }
@@ -125,10 +134,13 @@ static bool    startSimulator(t_table *table)
 /**
  * @brief Stops the philosopher simulation by joining all threads and cleaning up.
  *
- * This function waits for all philosopher threads and the monitor thread
- * to finish execution using `pthread_join`. Once all threads are properly
- * joined, it destroys all mutexes used in the simulation to prevent memory leaks
- * and undefined behavior.
+ * This function first waits for the seating controller, which freezes the
+ * seating, then for all seated philosopher threads (or, in process mode,
+ * reaps the philosopher processes) and the monitor thread
+ * using `pthread_join`. Once all threads are properly joined, it prints a
+ * last snapshot in snapshot output mode, flushes pending output, prints any
+ * end-of-run reports (the per-philosopher summary unless output is full)
+ * and destroys the table mutexes.
  *
  * It ensures a clean and synchronized shutdown of the simulation.
  *
@@ -138,10 +150,28 @@ static void    stopSimulator(t_table *table)
 {
     int i;
     
-    i = -1;
-    while (++ i < table->num_philos)
-        pthread_join(table->philos[i]->thread, NULL);
-    pthread_join(table->monitor, NULL);
+    if (table->control_path || table->checkpoint_path)
+        pthread_join(table->controller, NULL);
+    if (table->procs > 0)
+        waitPhilosophers(table);
+    else
+    {
+        i = -1;
+        while (++ i < table->seating->num_philos)
+            pthread_join(table->seating->philos[i]->thread, NULL);
+    }
+    if (NUM_PHILOS(table) > 1)
+        pthread_join(table->monitor, NULL);
+    if (table->output == OUT_SNAPSHOT)
+        writeSnapshot(table);
+    flushOutput(table);
+    if (table->output != OUT_FULL)
+        reportSummary(table);
+    if (table->control_path)
+        reportSeatingStats(table);
+    if (table->ckpt_stats.count > 0)
+        reportCheckpointStats(table);
+    PROF_REPORT(table);
     destroyMutex(table);
 }
 
@@ -156,7 +186,8 @@ static void    stopSimulator(t_table *table)
  * - Properly stops and frees all allocated resources when simulation ends
  * 
  * The simulator expects 4 or 5 arguments (number of philosophers, time to die,
- * time to eat, time to sleep, and optional minimum number of meals).
+ * time to eat, time to sleep, and optional minimum number of meals), followed
+ * by any number of key=value tuning options.
  *
  * @param ac The argument count.
  * @param av The argument vector (program arguments).
@@ -166,14 +197,13 @@ static void    stopSimulator(t_table *table)
  */
 int main(int ac, char **av)
 {
+    t_config    config;
     t_table *table;
 
-    if (ac < 5 || ac > 6)
-        return msg(ERR_USAGE, EXIT_FAILURE);
     table = NULL;
-    if (!isValid(ac, av))
+    if (!parseArgs(ac, av, &config))
         return EXIT_FAILURE;
-    table = initTable(ac, av);
+    table = initTable(&config);
     if (table == NULL)
         return EXIT_FAILURE;
     if (!startSimulator(table))
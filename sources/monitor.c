@@ -11,7 +11,7 @@
  */
 static void    reportDeath(t_philo *philo)
 {
-    pthread_mutex_lock(&philo->table->sim_stop_lock);
+    lockMutex(&philo->table->sim_stop_lock);
     if (philo->table->sim_stop == false)
     {
         philo->table->sim_stop = true;
@@ -33,13 +33,13 @@ static void    reportDeath(t_philo *philo)
  */
 bool hasPhiloDied(t_philo *philo)
 {
-    int elapsed_time;
+    time_t  elapsed_time;
 
-    pthread_mutex_lock(&philo->meal_time_lock);
-    elapsed_time = getTimeIn_ms() - philo->last_meal;
+    lockMutex(&philo->meal_time_lock);
+    elapsed_time = getTimeIn_us() - philo->last_meal;
     pthread_mutex_unlock(&philo->meal_time_lock);
 
-    if (elapsed_time >= philo->table->time_to_die)
+    if (elapsed_time >= TIME_TO_DIE(philo->table))
     {
         reportDeath(philo);
         return true;
@@ -52,28 +52,33 @@ bool hasPhiloDied(t_philo *philo)
  * @brief Check if any philosopher has died or if the simulation should stop.
  *
  * First checks the global stop flag. If set, returns true immediately.
- * Then iterates over all philosophers to check their individual status.
- * Finally, returns the updated stop status.
+ * Then iterates over the currently seated philosophers, inside an epoch so
+ * the seating cannot be reclaimed underneath, to check their individual
+ * status. Finally, returns the updated stop status.
  *
  * @param table Pointer to simulation table.
  * @return true if simulation should stop due to death, false otherwise.
  */
 bool    hasAnyoneDied(t_table *table)
 {
+    t_seating   *seating;
     bool    status;
     int i;
 
-    pthread_mutex_lock(&table->sim_stop_lock);
+    lockMutex(&table->sim_stop_lock);
     status = table->sim_stop;
     pthread_mutex_unlock(&table->sim_stop_lock);
     if (status)
         return status; 
+    epochEnter(table);
+    seating = currentSeating(table);
     i = -1;
-    while (++ i < table->num_philos)
+    while (++ i < SEATED(seating))
     {
-        hasPhiloDied(table->philos[i]);
+        hasPhiloDied(seating->philos[i]);
     }
-    pthread_mutex_lock(&table->sim_stop_lock);
+    epochExit();
+    lockMutex(&table->sim_stop_lock);
     status = table->sim_stop;
     pthread_mutex_unlock(&table->sim_stop_lock);
     return status;
@@ -93,7 +98,7 @@ bool    hasSimStopped(t_table *table)
 {
     bool  status;
 
-    pthread_mutex_lock(&table->sim_stop_lock);
+    lockMutex(&table->sim_stop_lock);
     status = table->sim_stop;
     pthread_mutex_unlock(&table->sim_stop_lock);
 
@@ -104,7 +109,7 @@ bool    hasSimStopped(t_table *table)
 /**
  * @brief Check if all philosophers have completed required meals.
  * 
- * Iterates through all philosophers and locks their meal_time_lock to
+ * Iterates through all seated philosophers and locks their meal_time_lock to
  * safely check if times_ate meets or exceeds min_dining.
  * Returns true only if all have eaten enough.
  * 
@@ -113,23 +118,27 @@ bool    hasSimStopped(t_table *table)
  */
 static bool areMealsCompleted(t_table *table)
 {
+    t_seating   *seating;
     int i;
     bool completed;
     
     completed = true;
     //if there is a value for min_dining, check all philosophers to see if they all ate.
+    epochEnter(table);
+    seating = currentSeating(table);
     i = -1;
-    while (++ i < table->num_philos)
+    while (++ i < SEATED(seating))
     {
-        pthread_mutex_lock(&table->philos[i]->meal_time_lock);
-        if (table->philos[i]->times_ate < table->min_dining)
+        lockMutex(&seating->philos[i]->meal_time_lock);
+        if (seating->philos[i]->times_ate < table->min_dining)
         {
-            pthread_mutex_unlock(&table->philos[i]->meal_time_lock);
+            pthread_mutex_unlock(&seating->philos[i]->meal_time_lock);
             completed = false;
             break;
         }
-        pthread_mutex_unlock(&table->philos[i]->meal_time_lock);
+        pthread_mutex_unlock(&seating->philos[i]->meal_time_lock);
     }
+    epochExit();
     return completed;
 }
 
@@ -137,10 +146,12 @@ static bool areMealsCompleted(t_table *table)
 /**
  * @brief Monitor thread to check philosophers' status.
  * 
- * Waits for simulation start time, then continuously checks:
+ * Waits for simulation start time, then continuously checks, pausing for
+ * the configured poll interval between rounds (busy-polling by default):
  * - if any philosopher died,
  * - if simulation should stop,
- * - if minimum meals completed (then stops simulation).
+ * - if minimum meals completed (then stops simulation),
+ * - in snapshot output mode, if the next snapshot is due.
  * Exits when simulation ends.
  * 
  * @param data Pointer to simulation table.
@@ -148,13 +159,20 @@ static bool areMealsCompleted(t_table *table)
  */
 void *monitor(void *data)
 {
-    t_table *table;
+    t_table         *table;
+    time_t          next_snapshot;
+    struct timespec poll;
 
     table = (t_table *)data;
+    PROF_BIND(&table->prof);
+    epochBind(&table->monitor_slot);
 
-    simStartDelay(table->start_time);
+    simStartDelay(table->launch_time);
+    next_snapshot = table->launch_time + table->snapshot_interval;
+    poll.tv_sec = table->poll_interval / 1000000;
+    poll.tv_nsec = (table->poll_interval % 1000000) * 1000;
 
-    if (table->time_to_die == 0)
+    if (TIME_TO_DIE(table) == 0)
         return NULL;
     while (true)
     {
@@ -165,12 +183,19 @@ void *monitor(void *data)
 
         if (table->min_dining != -1 && areMealsCompleted(table))
         {
-            pthread_mutex_lock(&table->sim_stop_lock);
+            lockMutex(&table->sim_stop_lock);
             table->sim_stop = true;
             pthread_mutex_unlock(&table->sim_stop_lock);
-            printf("ALL MEALS COMPLETE.\n");
+            writeMessage(table, "ALL MEALS COMPLETE.\n");
             break;
         }
+        if (table->output == OUT_SNAPSHOT && getTimeIn_us() >= next_snapshot)
+        {
+            writeSnapshot(table);
+            next_snapshot += table->snapshot_interval;
+        }
+        if (table->poll_interval)
+            nanosleep(&poll, NULL);
     }
     return NULL;
 }
\ No newline at end of file
@@ -1,35 +1,352 @@
 #include "philo.h"
 
+typedef struct s_message
+{
+    const char  *str;
+    size_t      len;
+} t_message;
+
+#define MESSAGE(s) { s, sizeof(s) - 1 }
+
+static const char *g_status_names[STATUS_COUNT] = {
+    "right_fork",
+    "left_fork",
+    "eating",
+    "sleeping",
+    "thinking",
+    "died",
+    "joined",
+    "left"
+};
+
+static const t_message g_messages[] = {
+    MESSAGE("has taken right fork\n"),
+    MESSAGE("has taken left fork\n"),
+    MESSAGE("is eating\n"),
+    MESSAGE("is sleeping\n"),
+    MESSAGE("is thinking\n"),
+    MESSAGE("died\n"),
+    MESSAGE("joined the table\n"),
+    MESSAGE("left the table\n")
+};
+
+
+/**
+ * @brief Write a signed integer in decimal at dst.
+ *
+ * Digits are produced right to left in a scratch buffer and copied out,
+ * matching what printf's %ld / %d would produce.
+ *
+ * @param dst Destination, must have room for at least 20 bytes.
+ * @param n Value to render.
+ * @return Number of bytes written.
+ */
+static size_t putNumber(char *dst, long n)
+{
+    char            tmp[20];
+    unsigned long   u;
+    size_t          len;
+    size_t          i;
+
+    u = n < 0 ? -(unsigned long)n : (unsigned long)n;
+    len = 0;
+    do
+    {
+        tmp[len++] = '0' + u % 10;
+        u /= 10;
+    } while (u != 0);
+    i = 0;
+    if (n < 0)
+        dst[i++] = '-';
+    while (len > 0)
+        dst[i++] = tmp[--len];
+    return i;
+}
+
+
+/**
+ * @brief Write a whole byte range to stdout.
+ *
+ * Retries on short writes and EINTR, gives up on any other error.
+ *
+ * @param buf Bytes to write.
+ * @param len Number of bytes.
+ */
+static void writeAll(const char *buf, size_t len)
+{
+    size_t  done;
+    ssize_t ret;
+
+    done = 0;
+    while (done < len)
+    {
+        ret = write(STDOUT_FILENO, buf + done, len - done);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            break;
+        done += ret;
+    }
+}
+
+
+/**
+ * @brief Write out everything pending in the output buffer.
+ *
+ * Caller must hold write_lock.
+ *
+ * @param table Pointer to the simulation table.
+ */
+static void drainOutput(t_table *table)
+{
+    writeAll(table->out_buf, table->out_len);
+    table->out_len = 0;
+}
+
+
+/**
+ * @brief Flush the shared output buffer to stdout.
+ *
+ * @param table Pointer to the simulation table.
+ */
+void flushOutput(t_table *table)
+{
+    lockMutex(&table->write_lock);
+    drainOutput(table);
+    pthread_mutex_unlock(&table->write_lock);
+}
+
+
+/**
+ * @brief Queue a free-form line behind any pending status lines and flush.
+ *
+ * @param table Pointer to the simulation table.
+ * @param str Newline-terminated message.
+ */
+void writeMessage(t_table *table, char *str)
+{
+    size_t  len;
+
+    len = strlen(str);
+    lockMutex(&table->write_lock);
+    if (table->out_cap - table->out_len < len)
+        drainOutput(table);
+    if (len > table->out_cap)
+        writeAll(str, len);
+    else
+    {
+        memcpy(table->out_buf + table->out_len, str, len);
+        table->out_len += len;
+    }
+    drainOutput(table);
+    pthread_mutex_unlock(&table->write_lock);
+}
+
+
+/**
+ * @brief Decide whether a status line is printed under the output level.
+ *
+ * Deaths and seating changes are rare and always printed. Below full
+ * output, deaths mode drops everything else, snapshot mode only counts the
+ * event for the monitor's next snapshot, and sample mode keeps every K-th
+ * event of each philosopher. Sample ticks and status counts are per
+ * philosopher, so threads never contend on a shared counter. Each count has
+ * a single writer at a time (the philosopher's thread; the controller only
+ * before the thread is seated or after it is joined; the one death report),
+ * so it is bumped with a plain load and store, atomic only so that
+ * writeSnapshot() may read it meanwhile.
+ *
+ * @param philo Pointer to the philosopher.
+ * @param state Status being reported.
+ * @return true if the line should be printed.
+ */
+static bool isStatusShown(t_philo *philo, STATUS state)
+{
+    t_table *table;
+
+    table = philo->table;
+    if (table->output == OUT_SNAPSHOT)
+        __atomic_store_n(&philo->events[state],
+            __atomic_load_n(&philo->events[state], __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+    if (state == DIED || state == JOINED || state == LEFT)
+        return true;
+    if (table->output == OUT_SAMPLE)
+        return ++philo->sample_tick % table->sample_every == 0;
+    return false;
+}
+
+
 /**
  * @brief Print the current status of a philosopher safely.
  *
- * Maps the status enum to a message, locks necessary mutexes to avoid
- * race conditions, then prints the timestamp, philosopher ID, and status.
+ * Outside full output mode the status is first filtered (see isStatusShown)
+ * without taking any lock. Otherwise locks necessary mutexes to avoid race
+ * conditions, then renders the timestamp, philosopher ID, and precomputed
+ * status message straight into the shared output buffer. The buffer is
+ * flushed when full, on death, and after every line when stdout is a
+ * terminal.
  *
  * @param philo Pointer to the philosopher.
  * @param state Current status of the philosopher.
  */
 void writeStatus(t_philo *philo, STATUS state)
 {
-    char    *str;
-
-    if (state == GOT_RIGHT_FORK)
-        str = "has taken right fork";
-    else if (state == GOT_LEFT_FORK)
-        str = "has taken left fork";
-    else if (state == EATING)
-        str = "is eating";
-    else if (state == SLEEPING)
-        str = "is sleeping";
-    else if (state == THINKING)
-        str = "is thinking";
-    else if (state == DIED)
-        str = "died";
-    pthread_mutex_lock(&philo->meal_time_lock);
-    pthread_mutex_lock(&philo->table->write_lock);
-    printf("%ld ms\t%d\t%s\n", 
-        getTimeIn_ms() - philo->table->start_time, philo->id, str);
+    t_table *table;
+    char    *dst;
+
+    table = philo->table;
+    if (table->output != OUT_FULL && !isStatusShown(philo, state))
+        return;
+    lockMutex(&philo->meal_time_lock);
+    PROF_BEGIN(write_wait);
+    lockMutex(&table->write_lock);
+    PROF_END(PH_WRITE_LOCK, write_wait);
+    if (table->out_cap - table->out_len < OUT_LINE_MAX)
+        drainOutput(table);
+    dst = table->out_buf + table->out_len;
+    dst += putNumber(dst, (getTimeIn_us() - table->start_time) / 1000);
+    memcpy(dst, " ms\t", 4);
+    dst += 4;
+    dst += putNumber(dst, philo->id);
+    *dst++ = '\t';
+    memcpy(dst, g_messages[state].str, g_messages[state].len);
+    dst += g_messages[state].len;
+    table->out_len = dst - table->out_buf;
+    if (state == DIED || table->out_line_flush)
+        drainOutput(table);
 
     pthread_mutex_unlock(&philo->meal_time_lock);
-    pthread_mutex_unlock(&philo->table->write_lock);
+    pthread_mutex_unlock(&table->write_lock);
+}
+
+
+/**
+ * @brief Print how many times each status occurred since the last snapshot.
+ *
+ * Sums the seated philosophers' counters, inside an epoch, on top of the
+ * counts folded in from philosophers that left. The folded counts are read
+ * first: a leaver is folded only after the seating without it is published,
+ * so it is then either still seen in the seating or already folded, never
+ * both. Only called by one thread at a time (the monitor, then the main
+ * thread once everything is joined), which owns events_seen.
+ *
+ * @param table Pointer to the simulation table.
+ */
+void writeSnapshot(t_table *table)
+{
+    t_seating   *seating;
+    char        line[OUT_LINE_MAX * 8];
+    long        count[STATUS_COUNT];
+    int         len;
+    int         i;
+    int         s;
+
+    s = -1;
+    while (++s < STATUS_COUNT)
+        count[s] = __atomic_load_n(&table->departed_events[s], __ATOMIC_SEQ_CST);
+    epochEnter(table);
+    seating = currentSeating(table);
+    i = -1;
+    while (++i < SEATED(seating))
+    {
+        s = -1;
+        while (++s < STATUS_COUNT)
+            count[s] += __atomic_load_n(&seating->philos[i]->events[s], __ATOMIC_RELAXED);
+    }
+    epochExit();
+    len = snprintf(line, sizeof(line), "SNAPSHOT\t%ld ms",
+        (long)((getTimeIn_us() - table->start_time) / 1000));
+    s = -1;
+    while (++s < STATUS_COUNT)
+    {
+        len += snprintf(line + len, sizeof(line) - len, "\t%s=%ld",
+            g_status_names[s], count[s] - table->events_seen[s]);
+        table->events_seen[s] = count[s];
+    }
+    snprintf(line + len, sizeof(line) - len, "\n");
+    writeMessage(table, line);
+}
+
+
+/**
+ * @brief Add one slack sample.
+ *
+ * @param slack Statistics to update.
+ * @param us Time that was left before starving, in microseconds.
+ */
+void addSlack(t_slack *slack, time_t us)
+{
+    if (slack->count == 0 || us < slack->min)
+        slack->min = us;
+    slack->sum += us;
+    slack->count ++;
+}
+
+
+/**
+ * @brief Add every slack sample of src into dst.
+ *
+ * @param dst Statistics receiving the samples.
+ * @param src Statistics to merge.
+ */
+void mergeSlack(t_slack *dst, t_slack *src)
+{
+    if (src->count == 0)
+        return;
+    if (dst->count == 0 || src->min < dst->min)
+        dst->min = src->min;
+    dst->sum += src->sum;
+    dst->count += src->count;
+}
+
+
+/**
+ * @brief Print one summary line, slack in milliseconds.
+ *
+ * @param who Label of the owner ("all" or a philosopher id).
+ * @param meals Meals completed.
+ * @param slack Slack statistics.
+ */
+static void printSummary(char *who, long meals, t_slack *slack)
+{
+    if (slack->count == 0)
+    {
+        printf("SUMMARY\t%s\tmeals=%ld\tslack_min_ms=-\tslack_avg_ms=-\n", who, meals);
+        return;
+    }
+    printf("SUMMARY\t%s\tmeals=%ld\tslack_min_ms=%.3f\tslack_avg_ms=%.3f\n",
+        who, meals, slack->min / 1000.0, (double)slack->sum / slack->count / 1000.0);
+}
+
+
+/**
+ * @brief Print each seated philosopher's meal count and slack, then totals.
+ *
+ * Slack is the time a philosopher had left before starving when it started
+ * a meal; a small minimum means the run came close to a death. Must be
+ * called after every thread has been joined. The totals also include
+ * philosophers that left the table.
+ *
+ * @param table Pointer to the simulation table.
+ */
+void reportSummary(t_table *table)
+{
+    t_seating   *seating;
+    t_slack     all;
+    long        meals;
+    char        who[16];
+    int         i;
+
+    seating = table->seating;
+    all = table->departed_slack;
+    meals = table->departed_meals;
+    i = -1;
+    while (++i < seating->num_philos)
+    {
+        snprintf(who, sizeof(who), "%d", seating->philos[i]->id);
+        printSummary(who, seating->philos[i]->times_ate, &seating->philos[i]->slack);
+        mergeSlack(&all, &seating->philos[i]->slack);
+        meals += seating->philos[i]->times_ate;
+    }
+    printSummary("all", meals, &all);
 }
@@ -1,42 +1,439 @@
 #include "philo.h"
 
+#define MAX_DURATION_US (INT64_MAX / 4)
+
 
 /**
- * @brief Validate command-line arguments.
+ * @brief Print a parse error naming the offending argument.
  *
- * Checks if the number of philosophers and timing values are positive integers.
- * Prints an error message and returns false if any validation fails.
+ * @param what Name of the parameter.
+ * @param str Argument as given.
+ * @param why Reason it was rejected.
+ * @return Always returns false.
+ */
+static bool parseError(const char *what, const char *str, const char *why)
+{
+    printf("Invalid %s '%s': %s.\n", what, str, why);
+    return false;
+}
+
+
+/**
+ * @brief Parse a run of decimal digits, rejecting overflow.
  *
- * @param ac Argument count.
- * @param av Argument vector.
- * @return true if all arguments are valid, false otherwise.
+ * @param str Cursor, advanced past the digits.
+ * @param max Largest accepted value.
+ * @param out Parsed value.
+ * @return Number of digits read, or -1 if the value exceeds max.
  */
-bool isValid(int ac, char **av)
+static int parseDigits(const char **str, long long max, long long *out)
 {
-    if (atoi(av[1]) < 1)
+    long long   v;
+    int         n;
+
+    v = 0;
+    n = 0;
+    while (**str >= '0' && **str <= '9')
     {
-        printf("Number of Philosophers must be a positive integer.\n");
+        if (v > (max - (**str - '0')) / 10)
+            return -1;
+        v = v * 10 + (**str - '0');
+        (*str)++;
+        n++;
+    }
+    *out = v;
+    return n;
+}
+
+
+/**
+ * @brief Scan a non-negative integer with nothing after it.
+ *
+ * @param str Argument to parse.
+ * @param max Largest accepted value.
+ * @param out Parsed value.
+ * @return NULL on success, otherwise the reason it was rejected.
+ */
+static const char *scanCount(const char *str, long long max, long long *out)
+{
+    const char  *p;
+    int         n;
+
+    p = str;
+    if (*p == '+')
+        p++;
+    if (*p == '-')
+        return "must not be negative";
+    n = parseDigits(&p, max, out);
+    if (n < 0)
+        return "value out of range";
+    if (n == 0 || *p != '\0')
+        return "expected a whole number";
+    return NULL;
+}
+
+
+/**
+ * @brief Parse a non-negative integer with nothing after it.
+ *
+ * @param what Name of the parameter, for error messages.
+ * @param str Argument to parse.
+ * @param max Largest accepted value.
+ * @param out Parsed value.
+ * @return true on success, false otherwise (the message is printed).
+ */
+static bool parseCount(const char *what, const char *str, long long max, long long *out)
+{
+    const char  *why;
+
+    why = scanCount(str, max, out);
+    if (why)
+        return parseError(what, str, why);
+    return true;
+}
+
+
+/**
+ * @brief Parse a philosopher ID given to a control command.
+ *
+ * Same rules as the command line counts, but silent: the caller reports
+ * the failed command on stderr, away from the simulation output.
+ *
+ * @param str Argument to parse.
+ * @param out Parsed ID.
+ * @return true on success, false otherwise.
+ */
+bool parseId(const char *str, int *out)
+{
+    long long   v;
+
+    if (scanCount(str, INT_MAX, &v))
         return false;
+    *out = (int)v;
+    return true;
+}
+
+
+/**
+ * @brief Parse a duration into microseconds.
+ *
+ * Accepts "<digits>[.<digits>][unit]" with unit one of "us", "ms" (the
+ * default) or "s". The fraction may not be finer than a microsecond.
+ *
+ * @param what Name of the parameter, for error messages.
+ * @param str Argument to parse.
+ * @param out Parsed duration in microseconds.
+ * @return true on success, false otherwise (the message is printed).
+ */
+bool parseDuration(const char *what, const char *str, time_t *out)
+{
+    const char  *p;
+    long long   whole;
+    long long   frac;
+    long long   scale;
+    int         frac_digits;
+    int         n;
+
+    p = str;
+    if (*p == '+')
+        p++;
+    if (*p == '-')
+        return parseError(what, str, "must not be negative");
+    n = parseDigits(&p, MAX_DURATION_US, &whole);
+    if (n < 0)
+        return parseError(what, str, "value out of range");
+    frac = 0;
+    frac_digits = 0;
+    if (*p == '.')
+    {
+        p++;
+        frac_digits = parseDigits(&p, MAX_DURATION_US, &frac);
+        if (frac_digits <= 0 || frac_digits > 6)
+            return parseError(what, str, "bad fractional part");
     }
-    if (atoi(av[2]) < 0)
+    if (n == 0 && frac_digits == 0)
+        return parseError(what, str, "expected a number");
+    if (strcmp(p, "us") == 0)
+        scale = 1;
+    else if (*p == '\0' || strcmp(p, "ms") == 0)
+        scale = 1000;
+    else if (strcmp(p, "s") == 0)
+        scale = 1000000;
+    else
+        return parseError(what, str, "unknown unit (use us, ms or s)");
+    while (frac_digits++ < 6)
+        frac *= 10;
+    if (frac % (1000000 / scale) != 0)
+        return parseError(what, str, "finer than a microsecond");
+    if (whole > (MAX_DURATION_US - frac / (1000000 / scale)) / scale)
+        return parseError(what, str, "value out of range");
+    *out = whole * scale + frac / (1000000 / scale);
+    return true;
+}
+
+
+/**
+ * @brief Parse a byte size with an optional k or m suffix.
+ *
+ * @param what Name of the parameter, for error messages.
+ * @param str Argument to parse.
+ * @param out Parsed size in bytes.
+ * @return true on success, false otherwise (the message is printed).
+ */
+static bool parseSize(const char *what, const char *str, size_t *out)
+{
+    const char  *p;
+    long long   v;
+    long long   scale;
+    int         n;
+
+    p = str;
+    n = parseDigits(&p, INT64_MAX, &v);
+    if (n < 0)
+        return parseError(what, str, "value out of range");
+    scale = 1;
+    if (*p == 'k' || *p == 'K')
+        scale = 1024;
+    else if (*p == 'm' || *p == 'M')
+        scale = 1024 * 1024;
+    if (scale != 1)
+        p++;
+    if (n == 0 || *p != '\0')
+        return parseError(what, str, "expected a size such as 4096, 64k or 8m");
+    if (v > (long long)(SIZE_MAX / 2) / scale)
+        return parseError(what, str, "value out of range");
+    *out = v * scale;
+    return true;
+}
+
+
+/**
+ * @brief Parse an output level: full, deaths, snapshot:<duration> or sample:<n>.
+ *
+ * @param cfg Configuration being filled.
+ * @param str Value of the output option.
+ * @return true on success, false otherwise (the message is printed).
+ */
+static bool parseOutput(t_config *cfg, const char *str)
+{
+    long long   v;
+
+    if (strcmp(str, "full") == 0)
+        cfg->output = OUT_FULL;
+    else if (strcmp(str, "deaths") == 0)
+        cfg->output = OUT_DEATHS;
+    else if (strncmp(str, "snapshot:", 9) == 0)
     {
-        printf("Time to die (milli seconds) must be a positive integer.\n");
-        return false;
+        if (!parseDuration("snapshot interval", str + 9, &cfg->snapshot_interval))
+            return false;
+        if (cfg->snapshot_interval < 1000)
+            return parseError("snapshot interval", str + 9, "must be at least 1ms");
+        cfg->output = OUT_SNAPSHOT;
     }
-    if (atoi(av[3]) < 0)
+    else if (strncmp(str, "sample:", 7) == 0)
     {
-        printf("Time to eat (milli seconds) must be a positive integer.\n");
-        return false;
+        if (!parseCount("sample rate", str + 7, LONG_MAX, &v))
+            return false;
+        if (v < 1)
+            return parseError("sample rate", str + 7, "must be at least 1");
+        cfg->sample_every = v;
+        cfg->output = OUT_SAMPLE;
     }
-    if (atoi(av[4]) < 0)
+    else
+        return parseError("output", str, "expected full, deaths, snapshot:<duration> or sample:<n>");
+    return true;
+}
+
+
+/**
+ * @brief Apply one key=value tuning option.
+ *
+ * @param cfg Configuration being filled.
+ * @param arg The whole "key=value" argument.
+ * @return true on success, false otherwise (the message is printed).
+ */
+static bool parseOption(t_config *cfg, char *arg)
+{
+    long long   v;
+    char        *val;
+    size_t      klen;
+
+    val = strchr(arg, '=') + 1;
+    klen = val - arg - 1;
+    if (klen == 4 && strncmp(arg, "poll", 4) == 0)
+        return parseDuration("poll", val, &cfg->poll_interval);
+    if (klen == 6 && strncmp(arg, "buffer", 6) == 0)
     {
-        printf("Time to sleep (milli seconds) must be a positive integer.\n");
-        return false;
+        if (!parseSize("buffer", val, &cfg->out_buffer))
+            return false;
+        if (cfg->out_buffer < OUT_LINE_MAX)
+            return parseError("buffer", val, "must be at least 64 bytes");
+        return true;
     }
-    if (ac == 6 && atoi(av[5]) < 0)
+    if (klen == 5 && strncmp(arg, "stack", 5) == 0)
+    {
+        if (!parseSize("stack", val, &cfg->stack_size))
+            return false;
+        if (cfg->stack_size < (size_t)PTHREAD_STACK_MIN)
+            return parseError("stack", val, "below the system minimum");
+        return true;
+    }
+    if (klen == 16 && strncmp(arg, "checkpoint_every", 16) == 0)
+    {
+        if (!parseDuration("checkpoint_every", val, &cfg->checkpoint_interval))
+            return false;
+        if (cfg->checkpoint_interval < 1000)
+            return parseError("checkpoint_every", val, "must be at least 1ms");
+        return true;
+    }
+    if (klen == 6 && strncmp(arg, "output", 6) == 0)
+        return parseOutput(cfg, val);
+    if (klen == 5 && strncmp(arg, "procs", 5) == 0)
+    {
+        if (!parseCount("procs", val, INT_MAX, &v))
+            return false;
+        if (v < 1)
+            return parseError("procs", val, "must be at least 1");
+        cfg->procs = (int)v;
+        return true;
+    }
+    if (klen == 4 && strncmp(arg, "mode", 4) == 0)
+    {
+        if (strcmp(val, "process") == 0)
+            cfg->process_mode = true;
+        else if (strcmp(val, "thread") == 0)
+            cfg->process_mode = false;
+        else
+            return parseError("mode", val, "expected thread or process");
+        return true;
+    }
+    if (*val == '\0')
+        return parseError("option", arg, "empty value");
+    if (klen == 7 && strncmp(arg, "control", 7) == 0)
+        cfg->control_path = val;
+    else if (klen == 10 && strncmp(arg, "checkpoint", 10) == 0)
+        cfg->checkpoint_path = val;
+    else if (klen == 7 && strncmp(arg, "restore", 7) == 0)
+        cfg->restore_path = val;
+    else if (klen == 6 && strncmp(arg, "record", 6) == 0)
+        cfg->record_path = val;
+    else if (klen == 6 && strncmp(arg, "replay", 6) == 0)
+        cfg->replay_path = val;
+    else
+        return parseError("option", arg, "unknown key");
+    return true;
+}
+
+
+/**
+ * @brief Check that the options can be combined.
+ *
+ * In process mode, philosophers live in other processes and only the
+ * memory built at startup is shared, so the seating cannot change and
+ * grant logs, which grow on the heap of whichever process takes the fork,
+ * cannot be recorded.
+ *
+ * @param cfg Parsed configuration.
+ * @return true if the options are compatible, false otherwise (the message is printed).
+ */
+static bool checkOptions(t_config *cfg)
+{
+    if (cfg->procs && !cfg->process_mode)
+        return parseError("option", "procs", "needs mode=process");
+    if (cfg->process_mode && cfg->control_path)
+        return parseError("option", "control", "not available with mode=process");
+    if (cfg->process_mode && cfg->record_path)
+        return parseError("option", "record", "not available with mode=process");
+    return true;
+}
+
+
+#ifdef FIXED_CONFIG
+/**
+ * @brief Check the arguments against the configuration this binary was built for.
+ *
+ * A specialized build has the philosopher count and durations compiled in,
+ * so any other values, and seating changes that would alter the count, are
+ * refused rather than silently ignored.
+ *
+ * @param cfg Parsed configuration.
+ * @return true if the configuration matches, false otherwise (the message is printed).
+ */
+static bool matchesSpec(t_config *cfg)
+{
+    if (cfg->num_philos != FIXED_NUM_PHILOS
+        || cfg->time_to_die != FIXED_US(FIXED_TIME_TO_DIE)
+        || cfg->time_to_eat != FIXED_US(FIXED_TIME_TO_EAT)
+        || cfg->time_to_sleep != FIXED_US(FIXED_TIME_TO_SLEEP))
     {
-        printf("Minimum number of meals each philosopher must eat must be a positive integer.\n");
+        printf("This build is specialized for %d %d %d %d; rebuild without SPEC for other values.\n",
+            FIXED_NUM_PHILOS, FIXED_TIME_TO_DIE, FIXED_TIME_TO_EAT, FIXED_TIME_TO_SLEEP);
         return false;
     }
+    if (cfg->control_path)
+        return parseError("option", "control", "seating changes need a build without SPEC");
+    return true;
+}
+#endif
+
+
+/**
+ * @brief Parse and validate command-line arguments.
+ *
+ * Expects the number of philosophers, time to die, time to eat and time to
+ * sleep, then an optional minimum number of meals, then any number of
+ * key=value tuning options. Durations are milliseconds unless suffixed with
+ * us, ms or s, and may carry a fraction down to the microsecond. Every
+ * argument is parsed strictly: trailing garbage, signs and overflow are
+ * rejected with a message naming the argument. A specialized build also
+ * rejects any configuration other than its own.
+ *
+ * @param ac Argument count.
+ * @param av Argument vector.
+ * @param cfg Configuration to fill.
+ * @return true if all arguments are valid, false otherwise.
+ */
+bool parseArgs(int ac, char **av, t_config *cfg)
+{
+    long long   v;
+    int         i;
+
+    memset(cfg, 0, sizeof(t_config));
+    cfg->min_dining = -1;
+    cfg->out_buffer = OUT_BUF_SIZE;
+    cfg->checkpoint_interval = 1000000;
+    if (ac < 5 || strchr(av[1], '=') || strchr(av[2], '=')
+        || strchr(av[3], '=') || strchr(av[4], '='))
+        return msg(ERR_USAGE, false);
+    if (!parseCount("number of philosophers", av[1], INT_MAX, &v))
+        return false;
+    if (v < 1)
+        return parseError("number of philosophers", av[1], "must be at least 1");
+    cfg->num_philos = (int)v;
+    if (!parseDuration("time to die", av[2], &cfg->time_to_die)
+        || !parseDuration("time to eat", av[3], &cfg->time_to_eat)
+        || !parseDuration("time to sleep", av[4], &cfg->time_to_sleep))
+        return false;
+    i = 5;
+    if (ac > 5 && !strchr(av[5], '='))
+    {
+        if (!parseCount("number of meals", av[5], LONG_MAX, &v))
+            return false;
+        cfg->min_dining = v;
+        i++;
+    }
+    while (i < ac)
+    {
+        if (!strchr(av[i], '='))
+            return parseError("argument", av[i], "expected key=value");
+        if (!parseOption(cfg, av[i++]))
+            return false;
+    }
+    if (!checkOptions(cfg))
+        return false;
+#ifdef FIXED_CONFIG
+    return matchesSpec(cfg);
+#else
     return true;
+#endif
 }
@@ -2,16 +2,21 @@
 
 
 /**
- * @brief Safely increment philosopher's meal count.
+ * @brief Safely end a meal, counting it if it was eaten in full.
  *
- * Locks meal_time mutex, increments times_ate, then unlocks.
+ * Locks meal_time mutex, clears the eating flag, increments times_ate if
+ * counted, then unlocks. Both happen in one step so a checkpoint sees the
+ * meal either in progress or counted, never neither.
  *
  * @param philo Pointer to the philosopher.
+ * @param counted Whether the meal counts towards times_ate.
  */
-static void updateTimesAte(t_philo *philo)
+static void endMeal(t_philo *philo, bool counted)
 {
-    pthread_mutex_lock(&philo->meal_time_lock);
-    philo->times_ate ++;
+    lockMutex(&philo->meal_time_lock);
+    philo->eating = false;
+    if (counted)
+        philo->times_ate ++;
     pthread_mutex_unlock(&philo->meal_time_lock);
 } 
 
@@ -19,58 +24,123 @@ static void updateTimesAte(t_philo *philo)
 /**
  * @brief Update philosopher's last meal timestamp safely.
  * 
- * Locks meal_time mutex, sets last_meal to current time in ms, then unlocks.
+ * Locks meal_time mutex, records how much time was left before starving,
+ * sets last_meal to current time in us and marks the philosopher as eating
+ * (both forks are held by now), then unlocks.
  *
  * @param philo Pointer to the philosopher.
  */
 static void stampLastMeal(t_philo *philo)
 {
-    pthread_mutex_lock(&philo->meal_time_lock);
-    philo->last_meal = getTimeIn_ms();
+    time_t  now;
+
+    now = getTimeIn_us();
+    lockMutex(&philo->meal_time_lock);
+    addSlack(&philo->slack, TIME_TO_DIE(philo->table) - (now - philo->last_meal));
+    philo->last_meal = now;
+    philo->eating = true;
     pthread_mutex_unlock(&philo->meal_time_lock);
 }
 
 
 /**
- * @brief Philosopher's eating routine.
+ * @brief Take a fork, blocking until it is free.
+ *
+ * In replay mode first waits for the philosopher's turn in the recorded
+ * grant order. Once held, the grant is logged.
+ *
+ * @param philo Pointer to the philosopher.
+ * @param fork Fork to take.
+ */
+static void takeFork(t_philo *philo, t_fork *fork)
+{
+    awaitGrantTurn(philo, fork);
+    lockMutex(&fork->lock);
+    noteGrant(philo, fork);
+}
+
+
+/**
+ * @brief Put a fork back on the table.
+ *
+ * @param fork Fork to release.
+ */
+static void dropFork(t_fork *fork)
+{
+    pthread_mutex_unlock(&fork->lock);
+}
+
+
+/**
+ * @brief Eat with the forks of the given seat.
  * 
  * Locks forks in order, checks simulation status between steps.
  * Updates last meal time, prints statuses, and simulates eating.
- * Unlocks forks after eating and updates times eaten.
+ * Ends the meal (counting it unless someone died) and unlocks forks. Forks
+ * already taken
+ * are always put back, also when the simulation stops midway, so that
+ * neighbours blocked on them can see the stop and exit.
  *
  * @param philo Pointer to the philosopher.
+ * @param seat Fork pair to use for this meal.
  */
-static void eatRoutine(t_philo *philo)
+static void eatAtSeat(t_philo *philo, t_seat *seat)
 {   
     if (hasAnyoneDied(philo->table))
         return;
-    pthread_mutex_lock(&philo->table->fork_locks[philo->fork[0]]);
+    PROF_BEGIN(fork0_wait);
+    takeFork(philo, seat->fork[0]);
+    PROF_END(PH_FORK_0, fork0_wait);
     if (hasAnyoneDied(philo->table))
+    {
+        dropFork(seat->fork[0]);
         return;
+    }
     writeStatus(philo, GOT_RIGHT_FORK);
 
     if (hasAnyoneDied(philo->table))
+    {
+        dropFork(seat->fork[0]);
         return;
-    pthread_mutex_lock(&philo->table->fork_locks[philo->fork[1]]);
+    }
+    PROF_BEGIN(fork1_wait);
+    takeFork(philo, seat->fork[1]);
+    PROF_END(PH_FORK_1, fork1_wait);
     if (hasAnyoneDied(philo->table))
+    {
+        dropFork(seat->fork[0]);
+        dropFork(seat->fork[1]);
         return;
+    }
     writeStatus(philo, GOT_LEFT_FORK);
 
     stampLastMeal(philo);
     
-    if (hasAnyoneDied(philo->table))
-        return;
-    if (philo->table->time_to_eat != 0)
+    if (!hasAnyoneDied(philo->table) && TIME_TO_EAT(philo->table) != 0)
     {
         writeStatus(philo, EATING);
-        lullPhilo(philo, philo->table->time_to_eat);
+        lullPhilo(philo, TIME_TO_EAT(philo->table));
     }
-    pthread_mutex_unlock(&philo->table->fork_locks[philo->fork[0]]);
-    pthread_mutex_unlock(&philo->table->fork_locks[philo->fork[1]]);
-    if (hasAnyoneDied(philo->table))
-        return;
+    endMeal(philo, !hasAnyoneDied(philo->table));
+    dropFork(seat->fork[0]);
+    dropFork(seat->fork[1]);
+}
 
-    updateTimesAte(philo);
+
+/**
+ * @brief Philosopher's eating routine.
+ * 
+ * Loads the philosopher's current seat inside an epoch, so neither the seat
+ * nor its forks can be reclaimed by a seating change mid-meal, and eats
+ * with it.
+ *
+ * @param philo Pointer to the philosopher.
+ */
+static void eatRoutine(t_philo *philo)
+{
+    epochEnter(philo->table);
+    eatAtSeat(philo, __atomic_load_n(&philo->seat, __ATOMIC_SEQ_CST));
+    epochExit();
 }
 
 
@@ -84,10 +154,10 @@ static void eatRoutine(t_philo *philo)
  */
 static void sleepRoutine(t_philo *philo)
 {
-    if (!hasAnyoneDied(philo->table) && philo->table->time_to_sleep != 0)
+    if (!hasAnyoneDied(philo->table) && TIME_TO_SLEEP(philo->table) != 0)
     {
         writeStatus(philo, SLEEPING);
-        lullPhilo(philo, philo->table->time_to_sleep);
+        lullPhilo(philo, TIME_TO_SLEEP(philo->table));
     }
 }
 
@@ -104,24 +174,24 @@ static void sleepRoutine(t_philo *philo)
  */
 static void thinkingRoutine(t_philo *philo, bool first)
 {
-    int thinking_time;
+    time_t  thinking_time;
 
     if (hasAnyoneDied(philo->table))
         return;
 
     thinking_time = 
-            (philo->table->time_to_die - philo->table->time_to_eat - philo->table->time_to_sleep) / 2;
+            (TIME_TO_DIE(philo->table) - TIME_TO_EAT(philo->table) - TIME_TO_SLEEP(philo->table)) / 2;
     if (!first)
     {
-        pthread_mutex_lock(&philo->meal_time_lock);
-        if (thinking_time > (philo->table->time_to_die - (getTimeIn_ms() - philo->last_meal))) 
+        lockMutex(&philo->meal_time_lock);
+        if (thinking_time > (TIME_TO_DIE(philo->table) - (getTimeIn_us() - philo->last_meal))) 
             thinking_time /= 2;
         pthread_mutex_unlock(&philo->meal_time_lock);
     }
     if (thinking_time <= 0)
-        thinking_time = 1;
-    else if (thinking_time > 600)
-        thinking_time = 200;
+        thinking_time = 1000;
+    else if (thinking_time > 600000)
+        thinking_time = 200000;
 
     if (!hasAnyoneDied(philo->table))
     {
@@ -131,6 +201,67 @@ static void thinkingRoutine(t_philo *philo, bool first)
 }
 
 
+/**
+ * @brief Finish the meal a restored philosopher was eating at checkpoint time.
+ *
+ * Retakes both forks and eats only for what was left of time_to_eat, keeping
+ * the recorded meal start; the meal's status lines were printed before the
+ * checkpoint. Eating a full meal again would starve the neighbours. The
+ * eating flag stays set from the restore until the meal ends.
+ *
+ * @param philo Pointer to the philosopher.
+ */
+static void resumeMeal(t_philo *philo)
+{
+    t_seat  *seat;
+    time_t  left;
+
+    epochEnter(philo->table);
+    seat = __atomic_load_n(&philo->seat, __ATOMIC_SEQ_CST);
+    takeFork(philo, seat->fork[0]);
+    takeFork(philo, seat->fork[1]);
+    lockMutex(&philo->meal_time_lock);
+    left = TIME_TO_EAT(philo->table) - (getTimeIn_us() - philo->last_meal);
+    pthread_mutex_unlock(&philo->meal_time_lock);
+    if (left > 0 && !hasAnyoneDied(philo->table))
+        lullPhilo(philo, left);
+    endMeal(philo, !hasAnyoneDied(philo->table));
+    dropFork(seat->fork[0]);
+    dropFork(seat->fork[1]);
+    epochExit();
+}
+
+
+/**
+ * @brief First think of a restored philosopher that was not eating.
+ *
+ * Meals are already staggered by the original run, so instead of the
+ * fresh-start stagger the philosopher thinks for half of the slack it has
+ * beyond one meal (capped at the stagger): the hungriest go for their forks
+ * first.
+ *
+ * @param philo Pointer to the philosopher.
+ */
+static void resumeThinking(t_philo *philo)
+{
+    time_t  thinking_time;
+    time_t  cap;
+
+    lockMutex(&philo->meal_time_lock);
+    thinking_time = (TIME_TO_DIE(philo->table) - (getTimeIn_us() - philo->last_meal)
+        - TIME_TO_EAT(philo->table)) / 2;
+    pthread_mutex_unlock(&philo->meal_time_lock);
+    cap = (TIME_TO_DIE(philo->table) - TIME_TO_EAT(philo->table)
+        - TIME_TO_SLEEP(philo->table)) / 2;
+    if (thinking_time > cap)
+        thinking_time = cap;
+    if (thinking_time <= 0 || hasAnyoneDied(philo->table))
+        return;
+    writeStatus(philo, THINKING);
+    lullPhilo(philo, thinking_time);
+}
+
+
 /**
  * @brief Routine for the single philosopher scenario.
  *
@@ -142,10 +273,13 @@ static void thinkingRoutine(t_philo *philo, bool first)
  */
 static void *lonePhiloRoutine(t_philo *philo)
 {
-    pthread_mutex_lock(&philo->table->fork_locks[philo->fork[0]]);
+    t_seat  *seat;
+
+    seat = philo->seat;
+    takeFork(philo, seat->fork[0]);
     writeStatus(philo, GOT_RIGHT_FORK);
-    lullPhilo(philo, philo->table->time_to_die);
-    pthread_mutex_unlock(&philo->table->fork_locks[philo->fork[0]]);
+    lullPhilo(philo, TIME_TO_DIE(philo->table));
+    dropFork(seat->fork[0]);
 
     return NULL;
 }
@@ -154,9 +288,11 @@ static void *lonePhiloRoutine(t_philo *philo)
 /**
  * @brief Main routine for each philosopher thread.
  *
- * Handles philosopher's lifecycle: waiting for simulation start,
- * special case for single philosopher, alternating actions of
- * thinking, eating, and sleeping until simulation stops or death.
+ * Handles philosopher's lifecycle: waiting for simulation start (and, for
+ * a philosopher joining a running simulation, for its seat), special case
+ * for single philosopher, alternating actions of thinking, eating, and
+ * sleeping until simulation stops, death, or the seating controller
+ * unseats the philosopher.
  *
  * @param data Pointer to philosopher structure.
  * @return NULL when routine ends.
@@ -166,17 +302,35 @@ void *philosopherRoutine(void *data)
     t_philo *philo;
 
     philo = (t_philo *)data;
+    PROF_BIND(&philo->prof);
+    epochBind(&philo->slot);
 
-    simStartDelay(philo->table->start_time);
+    simStartDelay(philo->table->launch_time);
+    while (!__atomic_load_n(&philo->seated, __ATOMIC_SEQ_CST))
+    {
+        if (hasLeftTable(philo))
+            return NULL;
+        usleep(100);
+    }
     if (hasPhiloDied(philo))
         return NULL;
-    if (philo->table->num_philos == 1)
+    if (NUM_PHILOS(philo->table) == 1)
         return lonePhiloRoutine(philo);
-    if (philo->id % 2)
+    if (philo->eating)
+    {
+        resumeMeal(philo);
+        sleepRoutine(philo);
+        thinkingRoutine(philo, false);
+    }
+    else if (philo->table->restored)
+    {
+        resumeThinking(philo);
+    }
+    else if (philo->id % 2)
     {
         thinkingRoutine(philo, true);
     }
-    while (!hasSimStopped(philo->table))
+    while (!hasSimStopped(philo->table) && !hasLeftTable(philo))
     {
         eatRoutine(philo);
         sleepRoutine(philo);
@@ -0,0 +1,263 @@
+#include "philo.h"
+
+#define ARENA_ALIGN 64
+
+static char     *g_arena = NULL;
+static size_t   g_arena_size = 0;
+static size_t   g_arena_used = 0;
+
+
+/**
+ * @brief Map the shared arena that holds all state touched by philosophers.
+ *
+ * Sized for the table, one seating of n philosophers with their forks,
+ * seats and status counters, and the output buffer, each allocation rounded up to a cache line.
+ * Must be called before anything is allocated with sharedAlloc(); the
+ * mapping is inherited by every child forked afterwards.
+ *
+ * @param n Number of philosophers.
+ * @param out_buffer Size of the output buffer in bytes.
+ * @return true on success, false if the mapping failed.
+ */
+bool openArena(int n, size_t out_buffer)
+{
+    size_t  size;
+
+    size = sizeof(t_table) + sizeof(t_seating) + out_buffer
+        + (size_t)n * (sizeof(t_philo) + sizeof(t_fork) + sizeof(t_seat)
+            + sizeof(long) * STATUS_COUNT + sizeof(t_philo *) + sizeof(t_fork *))
+        + ((size_t)n * 4 + 5) * ARENA_ALIGN;
+    g_arena = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (g_arena == MAP_FAILED)
+    {
+        g_arena = NULL;
+        return false;
+    }
+    g_arena_size = size;
+    g_arena_used = 0;
+    return true;
+}
+
+
+/**
+ * @brief Unmap the shared arena, if any.
+ */
+void closeArena(void)
+{
+    if (g_arena == NULL)
+        return;
+    munmap(g_arena, g_arena_size);
+    g_arena = NULL;
+}
+
+
+/**
+ * @brief Allocate memory visible to every philosopher.
+ *
+ * Blocks are cache-line aligned and rounded up to whole lines, which keeps
+ * neighbouring forks and philosophers' status counters off each other's
+ * lines. They are bump-allocated from the shared arena when one is mapped,
+ * and come from posix_memalign in thread mode. Arena allocation only
+ * happens while building the table, so it needs no locking.
+ *
+ * @param size Number of bytes.
+ * @return Pointer to the memory, or NULL if it is exhausted.
+ */
+void *sharedAlloc(size_t size)
+{
+    void    *ptr;
+
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (g_arena == NULL)
+        return posix_memalign(&ptr, ARENA_ALIGN, size) == 0 ? ptr : NULL;
+    if (size > g_arena_size - g_arena_used)
+        return NULL;
+    ptr = g_arena + g_arena_used;
+    g_arena_used += size;
+    return ptr;
+}
+
+
+/**
+ * @brief Release memory obtained from sharedAlloc().
+ *
+ * Arena blocks are reclaimed all at once by closeArena().
+ *
+ * @param ptr Pointer to the memory, may be NULL.
+ */
+void sharedFree(void *ptr)
+{
+    if (g_arena != NULL && (char *)ptr >= g_arena && (char *)ptr < g_arena + g_arena_size)
+        return;
+    free(ptr);
+}
+
+
+/**
+ * @brief Initialize a mutex that may be shared between processes.
+ *
+ * With the arena mapped, the mutex is process-shared and robust, so a
+ * philosopher process dying while holding it does not wedge the others.
+ *
+ * @param mutex Mutex to initialize.
+ * @return true on success, false otherwise.
+ */
+bool initLock(pthread_mutex_t *mutex)
+{
+    pthread_mutexattr_t attr;
+    bool                ok;
+
+    if (g_arena == NULL)
+        return pthread_mutex_init(mutex, NULL) == 0;
+    if (pthread_mutexattr_init(&attr) != 0)
+        return false;
+    ok = pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED) == 0
+        && pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST) == 0
+        && pthread_mutex_init(mutex, &attr) == 0;
+    pthread_mutexattr_destroy(&attr);
+    return ok;
+}
+
+
+/**
+ * @brief Lock a mutex, taking over robust mutexes whose owner died.
+ *
+ * The data a dead owner was updating is at worst one stale timestamp, meal
+ * count or eating flag, which the simulation tolerates, so the mutex is
+ * simply marked consistent again.
+ *
+ * @param mutex Mutex to lock.
+ */
+void lockMutex(pthread_mutex_t *mutex)
+{
+    if (pthread_mutex_lock(mutex) == EOWNERDEAD)
+        pthread_mutex_consistent(mutex);
+}
+
+
+/**
+ * @brief Tell every philosopher to stop.
+ *
+ * @param table Pointer to the simulation table.
+ */
+static void haltSimulation(t_table *table)
+{
+    lockMutex(&table->sim_stop_lock);
+    table->sim_stop = true;
+    pthread_mutex_unlock(&table->sim_stop_lock);
+}
+
+
+/**
+ * @brief Body of a philosopher process: run its block of philosophers.
+ *
+ * Child k runs the contiguous block of seats [k * n / procs,
+ * (k + 1) * n / procs) as threads, so neighbours mostly share a process
+ * and forks at block edges are contended across processes. If a thread
+ * cannot be started the simulation is stopped. The process is killed along
+ * with the supervisor, which may already be gone by the time the request
+ * is made, hence the parent check.
+ *
+ * @param table Pointer to the simulation table.
+ * @param k Index of the process.
+ * @param parent PID of the supervisor, taken before forking.
+ */
+static void runPhiloProcess(t_table *table, int k, pid_t parent)
+{
+    t_seating   *seating;
+    int         first;
+    int         last;
+    int         i;
+    int         status;
+
+    if (prctl(PR_SET_PDEATHSIG, SIGKILL) != 0 || getppid() != parent)
+        _exit(EXIT_FAILURE);
+    seating = table->seating;
+    first = (int)((long long)k * seating->num_philos / table->procs);
+    last = (int)((long long)(k + 1) * seating->num_philos / table->procs);
+    status = EXIT_SUCCESS;
+    i = first - 1;
+    while (++i < last)
+    {
+        if (!spawnThread(table, &seating->philos[i]->thread, &philosopherRoutine,
+                (void *)seating->philos[i]))
+        {
+            haltSimulation(table);
+            status = EXIT_FAILURE;
+            break;
+        }
+    }
+    while (--i >= first)
+        pthread_join(seating->philos[i]->thread, NULL);
+    _exit(status);
+}
+
+
+/**
+ * @brief Fork one process per group of philosophers.
+ *
+ * Must be called before the parent starts any thread, so no child inherits
+ * a lock held by a thread that does not exist in it. If a fork fails, the
+ * simulation is stopped and the children already started are reaped.
+ *
+ * @param table Pointer to the simulation table.
+ * @return true if every process was started, false otherwise.
+ */
+bool forkPhilosophers(t_table *table)
+{
+    pid_t   parent;
+    int     k;
+
+    table->pids = malloc(sizeof(pid_t) * table->procs);
+    if (!table->pids)
+        return false;
+    fflush(stdout);
+    parent = getpid();
+    k = -1;
+    while (++k < table->procs)
+    {
+        table->pids[k] = fork();
+        if (table->pids[k] == 0)
+            runPhiloProcess(table, k, parent);
+        if (table->pids[k] < 0)
+        {
+            haltSimulation(table);
+            table->procs = k;
+            waitPhilosophers(table);
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/**
+ * @brief Reap every philosopher process, reporting abnormal exits.
+ *
+ * A process that crashed simply stops feeding its philosophers; the monitor
+ * reports them as starved, which ends the run for the others.
+ *
+ * @param table Pointer to the simulation table.
+ */
+void waitPhilosophers(t_table *table)
+{
+    int status;
+    int k;
+
+    k = -1;
+    while (++k < table->procs)
+    {
+        status = 0;
+        while (waitpid(table->pids[k], &status, 0) < 0)
+        {
+            if (errno != EINTR)
+                break;
+        }
+        if (WIFSIGNALED(status))
+            fprintf(stderr, "Philosopher process %d killed by signal %d.\n",
+                (int)table->pids[k], WTERMSIG(status));
+        else if (WIFEXITED(status) && WEXITSTATUS(status) != EXIT_SUCCESS)
+            fprintf(stderr, "Philosopher process %d exited with status %d.\n",
+                (int)table->pids[k], WEXITSTATUS(status));
+    }
+}
@@ -0,0 +1,228 @@
+#include "philo.h"
+
+#ifdef PROFILE
+
+static __thread t_profile *g_prof = NULL;
+
+static const char *g_phase_names[PH_COUNT] = {
+    "fork[0] wait",
+    "fork[1] wait",
+    "lull oversleep",
+    "write_lock wait"
+};
+
+
+/**
+ * @brief Get a monotonic timestamp in nanoseconds.
+ *
+ * @return Current monotonic time in nanoseconds.
+ */
+long long profNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+/**
+ * @brief Attach a profile to the calling thread.
+ *
+ * Every sample recorded afterwards by this thread lands in the given profile,
+ * so the hot path never touches memory shared with other threads.
+ *
+ * @param prof Profile owned by the calling thread.
+ */
+void profBind(t_profile *prof)
+{
+    g_prof = prof;
+}
+
+
+/**
+ * @brief Map a value to its log-linear bucket.
+ *
+ * Values below PROF_SUB_COUNT get a bucket each; above that, every power of
+ * two is split into PROF_SUB_COUNT linear sub-buckets (HDR-style, ~12% error).
+ *
+ * @param v Non-negative value in nanoseconds.
+ * @return Bucket index.
+ */
+static int bucketOf(long long v)
+{
+    int shift;
+
+    if (v < PROF_SUB_COUNT)
+        return (int)v;
+    shift = 63 - __builtin_clzll((unsigned long long)v) - PROF_SUB_BITS;
+    return (shift + 1) * PROF_SUB_COUNT
+        + (int)((v >> shift) & (PROF_SUB_COUNT - 1));
+}
+
+
+/**
+ * @brief Lowest value that falls into the given bucket.
+ *
+ * @param b Bucket index.
+ * @return Lower bound of the bucket in nanoseconds.
+ */
+static long long bucketFloor(int b)
+{
+    int shift;
+
+    if (b < PROF_SUB_COUNT)
+        return b;
+    shift = b / PROF_SUB_COUNT - 1;
+    return (long long)(PROF_SUB_COUNT + b % PROF_SUB_COUNT) << shift;
+}
+
+
+/**
+ * @brief Record a sample for a phase in the calling thread's profile.
+ *
+ * Negative samples (clock granularity) are clamped to zero.
+ *
+ * @param phase Phase being measured.
+ * @param ns Duration in nanoseconds.
+ */
+void profRecord(PHASE phase, long long ns)
+{
+    t_histogram *h;
+
+    if (g_prof == NULL)
+        return;
+    if (ns < 0)
+        ns = 0;
+    h = &g_prof->phase[phase];
+    h->count ++;
+    h->sum += ns;
+    if (ns > h->max)
+        h->max = ns;
+    h->buckets[bucketOf(ns)] ++;
+}
+
+
+/**
+ * @brief Add every sample of src into dst.
+ *
+ * @param dst Histogram receiving the samples.
+ * @param src Histogram to merge.
+ */
+static void mergeHistogram(t_histogram *dst, t_histogram *src)
+{
+    int i;
+
+    dst->count += src->count;
+    dst->sum += src->sum;
+    if (src->max > dst->max)
+        dst->max = src->max;
+    i = -1;
+    while (++i < PROF_BUCKETS)
+        dst->buckets[i] += src->buckets[i];
+}
+
+
+/**
+ * @brief Add every sample of a profile into another.
+ *
+ * @param dst Profile receiving the samples.
+ * @param src Profile to merge.
+ */
+void profMerge(t_profile *dst, t_profile *src)
+{
+    int p;
+
+    p = -1;
+    while (++p < PH_COUNT)
+        mergeHistogram(&dst->phase[p], &src->phase[p]);
+}
+
+
+/**
+ * @brief Estimate the value at a given percentile.
+ *
+ * @param h Histogram to query.
+ * @param pct Percentile in the range [0, 100].
+ * @return Lower bound of the bucket holding the percentile, in nanoseconds.
+ */
+static long long percentile(t_histogram *h, double pct)
+{
+    long long   rank;
+    long long   seen;
+    int         i;
+
+    rank = (long long)(h->count * pct / 100.0);
+    if (rank >= h->count)
+        rank = h->count - 1;
+    seen = 0;
+    i = -1;
+    while (++i < PROF_BUCKETS)
+    {
+        seen += h->buckets[i];
+        if (seen > rank)
+            return bucketFloor(i);
+    }
+    return h->max;
+}
+
+
+/**
+ * @brief Print one histogram summary line, in microseconds.
+ *
+ * @param phase Phase the histogram belongs to.
+ * @param who Label of the owner ("all" or a philosopher id).
+ * @param h Histogram to print.
+ */
+static void printHistogram(PHASE phase, char *who, t_histogram *h)
+{
+    if (h->count == 0)
+        return;
+    printf("PROFILE\t%s\t%s\tn=%lld\tmean=%.1f\tp50=%.1f\tp99=%.1f\tmax=%.1f\n",
+        g_phase_names[phase], who, h->count,
+        (double)h->sum / h->count / 1000.0,
+        percentile(h, 50.0) / 1000.0,
+        percentile(h, 99.0) / 1000.0,
+        h->max / 1000.0);
+}
+
+
+/**
+ * @brief Merge all per-thread profiles and print the end-of-run report.
+ *
+ * Must be called after every thread has been joined. Prints one line per
+ * seated philosopher and phase, followed by the merged totals (which also
+ * include samples recorded by the monitor thread and by philosophers that
+ * left the table).
+ *
+ * @param table Pointer to the simulation table.
+ */
+void profReport(t_table *table)
+{
+    t_seating   *seating;
+    t_histogram *all;
+    char        who[16];
+    int         p;
+    int         i;
+
+    all = calloc(PH_COUNT, sizeof(t_histogram));
+    if (!all)
+        return;
+    seating = table->seating;
+    p = -1;
+    while (++p < PH_COUNT)
+    {
+        mergeHistogram(&all[p], &table->prof.phase[p]);
+        i = -1;
+        while (++i < seating->num_philos)
+        {
+            snprintf(who, sizeof(who), "%d", seating->philos[i]->id);
+            printHistogram(p, who, &seating->philos[i]->prof.phase[p]);
+            mergeHistogram(&all[p], &seating->philos[i]->prof.phase[p]);
+        }
+        printHistogram(p, "all", &all[p]);
+    }
+    free(all);
+}
+
+#endif
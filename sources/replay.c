@@ -0,0 +1,238 @@
+#include "philo.h"
+
+#define GRANT_CHUNK 4096
+
+/**
+ * @brief Append a philosopher ID to a grant log, growing it as needed.
+ *
+ * @param log Log to append to.
+ * @param id Philosopher ID.
+ * @return true on success, false if the log could not grow.
+ */
+static bool appendGrant(t_grant_log *log, int id)
+{
+    int *ids;
+    int cap;
+
+    if (log->len == log->cap)
+    {
+        cap = log->cap ? log->cap * 2 : 64;
+        ids = realloc(log->ids, sizeof(int) * cap);
+        if (!ids)
+            return false;
+        log->ids = ids;
+        log->cap = cap;
+    }
+    log->ids[log->len++] = id;
+    return true;
+}
+
+
+/**
+ * @brief Wait until the replayed schedule grants this fork to the philosopher.
+ *
+ * Does nothing outside replay mode or once the fork's recorded sequence is
+ * exhausted, after which acquisition is free again. Gives up waiting when
+ * the simulation stops so a diverging run cannot hang.
+ *
+ * @param philo Philosopher about to take the fork.
+ * @param fork Fork being taken.
+ */
+void awaitGrantTurn(t_philo *philo, t_fork *fork)
+{
+    int pos;
+
+    if (fork->replay.ids == NULL)
+        return;
+    while (true)
+    {
+        pos = __atomic_load_n(&fork->replay_pos, __ATOMIC_SEQ_CST);
+        if (pos >= fork->replay.len || fork->replay.ids[pos] == philo->id)
+            return;
+        if (hasSimStopped(philo->table))
+            return;
+        usleep(50);
+    }
+}
+
+
+/**
+ * @brief Write a fork's pending grants to the record file and empty the log.
+ *
+ * One line: "<fork id>:" followed by the IDs the fork was granted to, in
+ * order, and " ..." if grants were lost. Forks flush from different
+ * threads, so the file is locked for the whole line.
+ *
+ * @param fork Fork whose log to write.
+ */
+static void writeGrantLine(t_fork *fork)
+{
+    FILE    *file;
+    int     i;
+
+    file = fork->table->record_file;
+    flockfile(file);
+    fprintf(file, "%d:", fork->id);
+    i = -1;
+    while (++i < fork->record.len)
+        fprintf(file, " %d", fork->record.ids[i]);
+    fprintf(file, fork->record_truncated ? " ...\n" : "\n");
+    funlockfile(file);
+    fork->record.len = 0;
+    fork->record_truncated = false;
+}
+
+
+/**
+ * @brief Note that the philosopher now holds the fork.
+ *
+ * Called with the fork's mutex held, so the grant logs need no locking of
+ * their own: only the current holder ever appends or advances them. In
+ * record mode a fork keeps at most GRANT_CHUNK grants in memory and writes
+ * them out as a line of their own when the log is full, so a long
+ * recording does not grow without bound.
+ *
+ * @param philo Philosopher holding the fork.
+ * @param fork Fork just taken.
+ */
+void noteGrant(t_philo *philo, t_fork *fork)
+{
+    if (fork->replay.ids != NULL)
+        __atomic_add_fetch(&fork->replay_pos, 1, __ATOMIC_SEQ_CST);
+    if (philo->table->record_file == NULL)
+        return;
+    if (fork->record.len == GRANT_CHUNK)
+        writeGrantLine(fork);
+    if (!appendGrant(&fork->record, philo->id))
+        fork->record_truncated = true;
+}
+
+
+/**
+ * @brief Write out the rest of a fork's recorded grant sequence.
+ *
+ * Called when the fork is destroyed, at which point no philosopher can
+ * touch it and its sequence is final. A fork with nothing pending, such as
+ * one that was never granted, writes nothing.
+ *
+ * @param fork Fork being destroyed.
+ */
+void dumpGrants(t_fork *fork)
+{
+    if (fork->table->record_file == NULL
+        || (fork->record.len == 0 && !fork->record_truncated))
+        return;
+    writeGrantLine(fork);
+}
+
+
+/**
+ * @brief Hand a fork the replay sequence recorded under its ID, if any.
+ *
+ * Fork IDs are assigned in creation order, so a replayed run receiving the
+ * same seating commands sees the same IDs as the recorded one.
+ *
+ * @param table Pointer to the simulation table.
+ * @param fork Newly created fork.
+ */
+void attachReplay(t_table *table, t_fork *fork)
+{
+    if (fork->id < table->replay_count)
+        fork->replay = table->replay_logs[fork->id];
+}
+
+
+/**
+ * @brief Parse one "<fork id>: <id> <id> ..." line into the replay logs.
+ *
+ * A long recording spreads a fork's sequence over several lines, which are
+ * appended to each other in file order.
+ *
+ * @param table Pointer to the simulation table.
+ * @param line NUL-terminated line.
+ * @return true on success, false on malformed input or allocation failure.
+ */
+static bool parseGrantLine(t_table *table, char *line)
+{
+    t_grant_log *logs;
+    char        *end;
+    long        fork_id;
+    long        id;
+
+    fork_id = strtol(line, &end, 10);
+    if (end == line || *end != ':' || fork_id < 0 || fork_id > INT_MAX - 1)
+        return false;
+    if (fork_id >= table->replay_count)
+    {
+        logs = realloc(table->replay_logs, sizeof(t_grant_log) * (fork_id + 1));
+        if (!logs)
+            return false;
+        memset(logs + table->replay_count, 0,
+            sizeof(t_grant_log) * (fork_id + 1 - table->replay_count));
+        table->replay_logs = logs;
+        table->replay_count = fork_id + 1;
+    }
+    line = end + 1;
+    while (true)
+    {
+        id = strtol(line, &end, 10);
+        if (end == line)
+            break;
+        if (id < 1 || id > INT_MAX || !appendGrant(&table->replay_logs[fork_id], id))
+            return false;
+        line = end;
+    }
+    while (*line == ' ')
+        line++;
+    if (strncmp(line, "...", 3) == 0)
+        line += 3;
+    return *line == '\0' || *line == '\n';
+}
+
+
+/**
+ * @brief Load a recorded grant schedule for replay.
+ *
+ * @param table Pointer to the simulation table.
+ * @param path File written by a run with record=<path>.
+ * @return true on success, false otherwise (the message is printed).
+ */
+bool loadReplay(t_table *table, char *path)
+{
+    FILE    *file;
+    char    *line;
+    size_t  cap;
+    bool    ok;
+
+    file = fopen(path, "r");
+    if (!file)
+        return msg("Cannot open replay file.", false);
+    line = NULL;
+    cap = 0;
+    ok = true;
+    while (ok && getline(&line, &cap, file) != -1)
+        ok = parseGrantLine(table, line);
+    free(line);
+    fclose(file);
+    if (!ok)
+        return msg("Replay file is malformed.", false);
+    return true;
+}
+
+
+/**
+ * @brief Free every loaded replay sequence.
+ *
+ * @param table Pointer to the simulation table.
+ */
+void freeReplay(t_table *table)
+{
+    int i;
+
+    i = -1;
+    while (++i < table->replay_count)
+        free(table->replay_logs[i].ids);
+    free(table->replay_logs);
+    table->replay_logs = NULL;
+    table->replay_count = 0;
+}
@@ -0,0 +1,604 @@
+#include "philo.h"
+
+
+/**
+ * @brief Allocate a fork and initialize its mutex.
+ *
+ * @param table Pointer to the simulation table, used to number the fork.
+ * @return Pointer to the new fork, or NULL on failure.
+ */
+t_fork *createFork(t_table *table)
+{
+    t_fork  *fork;
+
+    fork = sharedAlloc(sizeof(t_fork));
+    if (!fork)
+        return NULL;
+    if (!initLock(&fork->lock))
+    {
+        sharedFree(fork);
+        return NULL;
+    }
+    fork->id = table->next_fork_id++;
+    fork->table = table;
+    memset(&fork->record, 0, sizeof(t_grant_log));
+    fork->record_truncated = false;
+    memset(&fork->replay, 0, sizeof(t_grant_log));
+    fork->replay_pos = 0;
+    attachReplay(table, fork);
+    return fork;
+}
+
+
+/**
+ * @brief Destroy a fork's mutex and free it.
+ *
+ * In record mode the fork's grant sequence, now final, is written out first.
+ *
+ * @param ptr Pointer to the fork.
+ */
+void destroyFork(void *ptr)
+{
+    t_fork  *fork;
+
+    fork = (t_fork *)ptr;
+    dumpGrants(fork);
+    free(fork->record.ids);
+    pthread_mutex_destroy(&fork->lock);
+    sharedFree(fork);
+}
+
+
+/**
+ * @brief Allocate a fork pair for a philosopher.
+ *
+ * @param left Fork taken first.
+ * @param right Fork taken second.
+ * @return Pointer to the new seat, or NULL on failure.
+ */
+static t_seat *createSeat(t_fork *left, t_fork *right)
+{
+    t_seat  *seat;
+
+    seat = sharedAlloc(sizeof(t_seat));
+    if (!seat)
+        return NULL;
+    seat->fork[0] = left;
+    seat->fork[1] = right;
+    return seat;
+}
+
+
+/**
+ * @brief Allocate and initialize a philosopher using the given forks.
+ *
+ * Assigns the next free ID, a fresh meal count, zeroed status counters
+ * (a block of their own, so no other philosopher's writes share their cache
+ * line) and an initialized meal_time_lock. last_meal is left for the caller to stamp, and the
+ * philosopher is not yet seated: its thread waits until the caller says so.
+ *
+ * @param table Pointer to the simulation table.
+ * @param left Fork taken first.
+ * @param right Fork taken second.
+ * @return Pointer to the new philosopher, or NULL on failure.
+ */
+t_philo *createPhilo(t_table *table, t_fork *left, t_fork *right)
+{
+    t_philo *philo;
+
+    philo = sharedAlloc(sizeof(t_philo));
+    if (!philo)
+        return NULL;
+    philo->seat = createSeat(left, right);
+    philo->events = sharedAlloc(sizeof(long) * STATUS_COUNT);
+    if (!philo->seat || !philo->events || !initLock(&philo->meal_time_lock))
+    {
+        sharedFree(philo->events);
+        sharedFree(philo->seat);
+        sharedFree(philo);
+        return NULL;
+    }
+    memset(philo->events, 0, sizeof(long) * STATUS_COUNT);
+    philo->id = table->next_id++;
+    philo->times_ate = 0;
+    memset(&philo->slack, 0, sizeof(t_slack));
+    philo->sample_tick = 0;
+    philo->leaving = false;
+    philo->seated = false;
+    philo->eating = false;
+    philo->slot.epoch = 0;
+    philo->slot.depth = 0;
+    philo->table = table;
+#ifdef PROFILE
+    memset(&philo->prof, 0, sizeof(t_profile));
+#endif
+    return philo;
+}
+
+
+/**
+ * @brief Destroy a philosopher's mutex and free it along with its seat.
+ *
+ * @param ptr Pointer to the philosopher.
+ */
+void destroyPhilo(void *ptr)
+{
+    t_philo *philo;
+
+    philo = (t_philo *)ptr;
+    pthread_mutex_destroy(&philo->meal_time_lock);
+    sharedFree(philo->events);
+    sharedFree(philo->seat);
+    sharedFree(philo);
+}
+
+
+/**
+ * @brief Allocate an empty seating snapshot for n philosophers.
+ *
+ * @param n Number of seats.
+ * @return Pointer to the new seating, or NULL on failure.
+ */
+t_seating *createSeating(int n)
+{
+    t_seating   *seating;
+
+    seating = sharedAlloc(sizeof(t_seating));
+    if (!seating)
+        return NULL;
+    seating->num_philos = n;
+    seating->philos = sharedAlloc(sizeof(t_philo *) * n);
+    seating->forks = sharedAlloc(sizeof(t_fork *) * n);
+    if (!seating->philos || !seating->forks)
+    {
+        destroySeating(seating);
+        return NULL;
+    }
+    return seating;
+}
+
+
+/**
+ * @brief Free a seating snapshot, leaving the philosophers and forks alone.
+ *
+ * @param ptr Pointer to the seating.
+ */
+void destroySeating(void *ptr)
+{
+    t_seating   *seating;
+
+    seating = (t_seating *)ptr;
+    sharedFree(seating->philos);
+    sharedFree(seating->forks);
+    sharedFree(seating);
+}
+
+
+/**
+ * @brief Load the seating currently published on the table.
+ *
+ * Readers other than the controller must be inside epochEnter()/epochExit().
+ *
+ * @param table Pointer to the simulation table.
+ * @return Current seating snapshot.
+ */
+t_seating *currentSeating(t_table *table)
+{
+    return __atomic_load_n(&table->seating, __ATOMIC_SEQ_CST);
+}
+
+
+/**
+ * @brief Check whether the controller has asked this philosopher to leave.
+ *
+ * @param philo Pointer to the philosopher.
+ * @return true once the philosopher has been unseated.
+ */
+bool hasLeftTable(t_philo *philo)
+{
+    return __atomic_load_n(&philo->leaving, __ATOMIC_SEQ_CST);
+}
+
+
+/**
+ * @brief Find the ring position of a philosopher ID.
+ *
+ * @param seating Seating to search.
+ * @param id Philosopher ID.
+ * @return Index in the ring, or -1 if the ID is not seated.
+ */
+static int seatOf(t_seating *seating, int id)
+{
+    int i;
+
+    i = -1;
+    while (++i < seating->num_philos)
+    {
+        if (seating->philos[i]->id == id)
+            return i;
+    }
+    return -1;
+}
+
+
+/**
+ * @brief Publish a new seating and hand the old objects to the reclaimer.
+ *
+ * Every philosopher whose fork pair differs in the new ring gets a fresh
+ * seat. All allocations happen before anything is published, so a failure
+ * leaves the running simulation untouched. After the new seats and seating
+ * are visible the global epoch is advanced; the replaced seats, the old
+ * seating and the given fork are retired.
+ *
+ * @param table Pointer to the simulation table.
+ * @param next New seating, fully populated.
+ * @param gone Fork dropped from the ring, or NULL.
+ * @return true on success, false if an allocation failed.
+ */
+static bool publishSeating(t_table *table, t_seating *next, t_fork *gone)
+{
+    t_seat  **seats;
+    t_seat  *old;
+    int     n;
+    int     i;
+
+    n = next->num_philos;
+    seats = calloc(n, sizeof(t_seat *));
+    if (!seats)
+        return false;
+    i = -1;
+    while (++i < n)
+    {
+        old = next->philos[i]->seat;
+        if (old->fork[0] == next->forks[i] && old->fork[1] == next->forks[(i + 1) % n])
+            continue;
+        seats[i] = createSeat(next->forks[i], next->forks[(i + 1) % n]);
+        if (!seats[i])
+        {
+            while (i >= 0)
+                sharedFree(seats[i--]);
+            free(seats);
+            return false;
+        }
+    }
+    i = -1;
+    while (++i < n)
+    {
+        if (!seats[i])
+            continue;
+        old = next->philos[i]->seat;
+        __atomic_store_n(&next->philos[i]->seat, seats[i], __ATOMIC_SEQ_CST);
+        epochRetire(table, old, sharedFree);
+    }
+    epochRetire(table, table->seating, destroySeating);
+    if (gone)
+        epochRetire(table, gone, destroyFork);
+    __atomic_store_n(&table->seating, next, __ATOMIC_SEQ_CST);
+    epochAdvance(table);
+    free(seats);
+    return true;
+}
+
+
+/**
+ * @brief Undo a join that failed before its seating was published.
+ *
+ * The newcomer and its fork never reached the seating, so they are
+ * destroyed outright, and their IDs (the last ones handed out, as only the
+ * controller creates philosophers and forks) are given back. Otherwise a
+ * replay of the same commands would number later forks and philosophers
+ * differently from the recording.
+ *
+ * @param table Pointer to the simulation table.
+ * @param philo Newcomer, its thread not running.
+ * @param fork Fork it brought.
+ * @param next Unpublished seating.
+ */
+static void abandonJoin(t_table *table, t_philo *philo, t_fork *fork, t_seating *next)
+{
+    table->next_id = philo->id;
+    table->next_fork_id = fork->id;
+    destroyPhilo(philo);
+    destroyFork(fork);
+    destroySeating(next);
+}
+
+
+/**
+ * @brief Seat a new philosopher right after the given one.
+ *
+ * The newcomer shares its first fork with its left neighbour and brings a
+ * new fork, which becomes the first fork of its right neighbour. Its thread
+ * waits until the seating is published and "joined the table" printed, so
+ * a failed join prints nothing and no status precedes the join line.
+ *
+ * @param table Pointer to the simulation table.
+ * @param after_id ID to sit next to, or -1 for the end of the ring.
+ * @return true on success, false otherwise.
+ */
+static bool joinTable(t_table *table, int after_id)
+{
+    t_seating   *cur;
+    t_seating   *next;
+    t_philo     *philo;
+    t_fork      *fork;
+    time_t      begin;
+    int         p;
+    int         i;
+
+    begin = getTimeIn_us();
+    cur = table->seating;
+    p = cur->num_philos - 1;
+    if (after_id != -1)
+        p = seatOf(cur, after_id);
+    if (p < 0)
+        return false;
+    p = (p + 1) % cur->num_philos;
+    next = createSeating(cur->num_philos + 1);
+    if (!next)
+        return false;
+    fork = createFork(table);
+    philo = NULL;
+    if (fork)
+        philo = createPhilo(table, cur->forks[p], fork);
+    if (!philo)
+    {
+        if (fork)
+        {
+            table->next_fork_id = fork->id;
+            destroyFork(fork);
+        }
+        destroySeating(next);
+        return false;
+    }
+    i = -1;
+    while (++i < next->num_philos)
+    {
+        next->philos[i] = (i < p) ? cur->philos[i] : (i == p) ? philo : cur->philos[i - 1];
+        next->forks[i] = (i <= p) ? cur->forks[i] : (i == p + 1) ? fork : cur->forks[i - 1];
+    }
+    philo->last_meal = getTimeIn_us();
+    if (!spawnThread(table, &philo->thread, &philosopherRoutine, (void *)philo))
+    {
+        abandonJoin(table, philo, fork, next);
+        return false;
+    }
+    if (!publishSeating(table, next, NULL))
+    {
+        // The newcomer is already running but was never published; stop it.
+        __atomic_store_n(&philo->leaving, true, __ATOMIC_SEQ_CST);
+        pthread_join(philo->thread, NULL);
+        abandonJoin(table, philo, fork, next);
+        return false;
+    }
+    writeStatus(philo, JOINED);
+    __atomic_store_n(&philo->seated, true, __ATOMIC_SEQ_CST);
+    table->seating_stats.joins ++;
+    table->seating_stats.publish_us += getTimeIn_us() - begin;
+    return true;
+}
+
+
+/**
+ * @brief Fold a departing philosopher's meals, slack and status counts into
+ * the table.
+ *
+ * Done as soon as its thread has been joined, not when it is reclaimed, so
+ * the totals (and in profiling builds the table's profile) include it even
+ * if the simulation ends while it still waits in limbo. Status counts are
+ * added atomically after the philosopher left the seating, which is what
+ * lets writeSnapshot() count each event once.
+ *
+ * @param table Pointer to the simulation table.
+ * @param philo Philosopher whose thread has exited.
+ */
+static void foldDeparted(t_table *table, t_philo *philo)
+{
+    int s;
+
+    s = -1;
+    while (++s < STATUS_COUNT)
+        __atomic_add_fetch(&table->departed_events[s], philo->events[s], __ATOMIC_SEQ_CST);
+    table->departed_meals += philo->times_ate;
+    mergeSlack(&table->departed_slack, &philo->slack);
+#ifdef PROFILE
+    profMerge(&table->prof, &philo->prof);
+#endif
+}
+
+
+/**
+ * @brief Unseat a philosopher and re-link its neighbours.
+ *
+ * The leaver's second fork is dropped from the ring (its first fork when it
+ * sits last, so the array stays contiguous), and the neighbour that used it
+ * moves over to the leaver's other fork. The leaver is joined before being
+ * retired, so only the remaining readers need to pass the grace period.
+ *
+ * @param table Pointer to the simulation table.
+ * @param id ID of the philosopher leaving.
+ * @return true on success, false otherwise.
+ */
+static bool leaveTable(t_table *table, int id)
+{
+    t_seating   *cur;
+    t_seating   *next;
+    t_philo     *philo;
+    time_t      begin;
+    int         p;
+    int         f;
+    int         i;
+
+    begin = getTimeIn_us();
+    cur = table->seating;
+    p = seatOf(cur, id);
+    if (p < 0 || cur->num_philos <= 2)
+        return false;
+    philo = cur->philos[p];
+    f = (p + 1 == cur->num_philos) ? p : p + 1;
+    next = createSeating(cur->num_philos - 1);
+    if (!next)
+        return false;
+    i = -1;
+    while (++i < next->num_philos)
+    {
+        next->philos[i] = cur->philos[i < p ? i : i + 1];
+        next->forks[i] = cur->forks[i < f ? i : i + 1];
+    }
+    if (!publishSeating(table, next, cur->forks[f]))
+    {
+        destroySeating(next);
+        return false;
+    }
+    table->seating_stats.publish_us += getTimeIn_us() - begin;
+    begin = getTimeIn_us();
+    __atomic_store_n(&philo->leaving, true, __ATOMIC_SEQ_CST);
+    pthread_join(philo->thread, NULL);
+    writeStatus(philo, LEFT);
+    foldDeparted(table, philo);
+    epochRetire(table, philo, destroyPhilo);
+    table->seating_stats.leaves ++;
+    table->seating_stats.drain_us += getTimeIn_us() - begin;
+    return true;
+}
+
+
+/**
+ * @brief Execute one control command.
+ *
+ * Supported commands:
+ * - "join"        seat a new philosopher at the end of the ring
+ * - "join <id>"   seat a new philosopher right after philosopher <id>
+ * - "leave <id>"  unseat philosopher <id> (at least two must remain)
+ * - "checkpoint <path>"  snapshot the simulation to <path>
+ *
+ * @param table Pointer to the simulation table.
+ * @param line NUL-terminated command without its newline.
+ */
+static void runCommand(t_table *table, char *line)
+{
+    char    *arg;
+    int     id;
+    bool    ok;
+
+    arg = strchr(line, ' ');
+    if (arg)
+        *arg++ = '\0';
+    id = -1;
+    if (strcmp(line, "join") == 0)
+        ok = (!arg || parseId(arg, &id)) && joinTable(table, id);
+    else if (strcmp(line, "leave") == 0 && arg)
+        ok = parseId(arg, &id) && leaveTable(table, id);
+    else if (strcmp(line, "checkpoint") == 0 && arg)
+        ok = saveCheckpoint(table, arg);
+    else if (line[0] == '\0')
+        return;
+    else
+        ok = false;
+    if (!ok)
+        fprintf(stderr, "Control command failed: %s%s%s\n", line, arg ? " " : "", arg ? arg : "");
+}
+
+
+/**
+ * @brief Read and execute every complete command waiting in the control file.
+ *
+ * Partial lines are kept in the buffer until their newline arrives; a line
+ * longer than the buffer is dropped.
+ *
+ * @param table Pointer to the simulation table.
+ * @param fd Control file descriptor (non-blocking).
+ * @param line Line buffer of CONTROL_LINE_MAX bytes.
+ * @param len Number of pending bytes in line, updated.
+ * @return true if anything was read.
+ */
+static bool pollControl(t_table *table, int fd, char *line, size_t *len)
+{
+    char    *nl;
+    ssize_t ret;
+
+    ret = read(fd, line + *len, CONTROL_LINE_MAX - *len - 1);
+    if (ret <= 0)
+        return false;
+    *len += ret;
+    line[*len] = '\0';
+    while ((nl = strchr(line, '\n')) != NULL)
+    {
+        *nl = '\0';
+        runCommand(table, line);
+        *len -= nl + 1 - line;
+        memmove(line, nl + 1, *len + 1);
+    }
+    if (*len == CONTROL_LINE_MAX - 1)
+        *len = 0;
+    return true;
+}
+
+
+/**
+ * @brief Seating controller thread.
+ *
+ * Follows the control file (a regular file, FIFO or /dev/stdin), if one is
+ * configured, and applies each newline-terminated command as it appears.
+ * When periodic checkpoints are configured it also snapshots the
+ * simulation every checkpoint_interval microseconds. Retired objects are reclaimed
+ * between polls. It is the only thread that changes the seating. Exits
+ * when the simulation stops.
+ *
+ * @param data Pointer to simulation table.
+ * @return Always returns NULL.
+ */
+void *seatingController(void *data)
+{
+    t_table *table;
+    char    line[CONTROL_LINE_MAX];
+    size_t  len;
+    time_t  next_ckpt;
+    int     fd;
+
+    table = (t_table *)data;
+    fd = -1;
+    if (table->control_path)
+    {
+        fd = open(table->control_path, O_RDONLY | O_NONBLOCK);
+        if (fd < 0)
+            fprintf(stderr, "Cannot open control file: %s\n", table->control_path);
+    }
+    simStartDelay(table->launch_time);
+    len = 0;
+    next_ckpt = getTimeIn_us() + table->checkpoint_interval;
+    while (!hasSimStopped(table))
+    {
+        if (table->checkpoint_path && getTimeIn_us() >= next_ckpt)
+        {
+            if (!saveCheckpoint(table, table->checkpoint_path))
+                fprintf(stderr, "Checkpoint failed: %s\n", table->checkpoint_path);
+            next_ckpt = getTimeIn_us() + table->checkpoint_interval;
+        }
+        if (fd < 0 || !pollControl(table, fd, line, &len))
+            usleep(1000);
+        epochReclaim(table);
+    }
+    if (fd >= 0)
+        close(fd);
+    return NULL;
+}
+
+
+/**
+ * @brief Print the cost of every seating change made during the run.
+ *
+ * @param table Pointer to the simulation table.
+ */
+void reportSeatingStats(t_table *table)
+{
+    t_seating_stats *s;
+
+    s = &table->seating_stats;
+    printf("SEATING\tjoins=%d\tleaves=%d\tpublish_avg_us=%.1f\tdrain_avg_us=%.1f\treclaimed=%d\tgrace_avg_ms=%.1f\n",
+        s->joins, s->leaves,
+        (s->joins + s->leaves) ? (double)s->publish_us / (s->joins + s->leaves) : 0.0,
+        s->leaves ? (double)s->drain_us / s->leaves : 0.0,
+        s->reclaimed,
+        s->reclaimed ? (double)s->grace_ms / s->reclaimed : 0.0);
+}
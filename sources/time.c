@@ -6,11 +6,11 @@
  *
  * Loops until current time reaches or exceeds given time.
  *
- * @param time Target start time in milliseconds.
+ * @param time Target start time in microseconds.
  */
 void simStartDelay(time_t time)
 {
-    while (getTimeIn_ms() < time)
+    while (getTimeIn_us() < time)
         continue;
 }
 
@@ -32,25 +32,46 @@ time_t getTimeIn_ms(void)
 }
 
 
+/**
+ * @brief Get current time in microseconds.
+ *
+ * @return Current time in microseconds.
+ */
+time_t getTimeIn_us(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (tv.tv_sec * 1000000) + tv.tv_usec;
+}
+
+
 /**
  * @brief Pause philosopher activity for given time or until death occurs.
  *
- * Sleeps in small increments (1 ms) until the specified session
- * duration elapses or any philosopher dies.
+ * Sleeps in small increments (at most 1 ms, less for the final stretch)
+ * until the specified session duration elapses or any philosopher dies.
+ * The oversleep is profiled from the overshoot past the session, which
+ * stays small; scaling the session itself to nanoseconds could overflow.
  *
  * @param philo Pointer to the philosopher.
- * @param session Duration to sleep in milliseconds.
+ * @param session Duration to sleep in microseconds.
  */
-void    lullPhilo(t_philo *philo, int session)
+void    lullPhilo(t_philo *philo, time_t session)
 {
     time_t  beginning;
+    time_t  remaining;
 
-    beginning = getTimeIn_ms();
+    beginning = getTimeIn_us();
     while (hasAnyoneDied(philo->table) == false)
     {
-        if (getTimeIn_ms() - beginning < session)
-            usleep(1000);
+        remaining = session - (getTimeIn_us() - beginning);
+        if (remaining > 0)
+            usleep(remaining < 1000 ? remaining : 1000);
         else
+        {
+            PROF_RECORD(PH_OVERSLEEP, -remaining * 1000LL);
             break;
+        }
     }
 }
\ No newline at end of file
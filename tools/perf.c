@@ -0,0 +1,550 @@
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PERF_RUNS 3
+#define PERF_TIMEOUT_MS 60000
+#define PERF_ARGS_MAX 16
+#define PERF_LINE_MAX 512
+
+/*
+ * Representative configurations, run with output=deaths: a small even ring,
+ * an odd ring and a larger one. None of them may die, since a dying run
+ * stops early and its timings then measure how soon someone starved. Keep
+ * the count modest: the simulator waits 20 ms per philosopher before
+ * starting, which every timing includes.
+ */
+static const char *g_configs[] = {
+    "5 800 200 200 20",
+    "31 1000 200 200 10",
+    "100 1000 200 200 10"
+};
+#define PERF_CONFIGS (int)(sizeof(g_configs) / sizeof(g_configs[0]))
+
+typedef enum e_metric
+{
+    M_WALL,             //0
+    M_CPU,              //1
+    M_CTXSW,            //2
+    M_MEALS_PER_S,      //3
+    M_DEATHS,           //4
+    M_TIMEOUTS,         //5
+    M_COUNT             //6
+} METRIC;
+
+/*
+ * How far a metric may drift from the baseline before it counts as a
+ * regression: relative for timings and throughput, absolute for counts of
+ * runs that died or hung, where any new one fails. Throughput is only gated
+ * on configurations whose baseline runs all finished: a death cuts a run
+ * short at a moment that varies from run to run, so meals per second swings
+ * widely there.
+ */
+typedef struct s_limit
+{
+    const char  *name;
+    bool        higher_is_worse;
+    double      ratio;
+    double      slack;
+} t_limit;
+
+static const t_limit g_limits[M_COUNT] = {
+    { "wall_ms",        true,   1.20,   0.0 },
+    { "cpu_ms",         true,   1.25,   5.0 },
+    { "ctxsw",          true,   1.50,   100.0 },
+    { "meals_per_s",    false,  0.85,   0.0 },
+    { "deaths",         true,   1.00,   0.0 },
+    { "timeouts",       true,   1.00,   0.0 }
+};
+
+/* One run of the simulator */
+typedef struct s_run
+{
+    double  wall_ms;
+    double  cpu_ms;
+    double  ctxsw;
+    long    meals;
+    bool    died;
+    bool    timed_out;
+} t_run;
+
+
+/**
+ * @brief Get current monotonic time in milliseconds.
+ *
+ * @return Current time in milliseconds.
+ */
+static double nowIn_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+
+/**
+ * @brief Scan one line of simulator output for deaths and the meal total.
+ *
+ * @param line NUL-terminated line without its newline.
+ * @param run Run being measured.
+ */
+static void scanLine(const char *line, t_run *run)
+{
+    const char  *p;
+
+    p = strstr(line, "\tdied");
+    if (p && p[5] == '\0')
+        run->died = true;
+    if (strncmp(line, "SUMMARY\tall\tmeals=", 18) == 0)
+        run->meals = strtol(line + 18, NULL, 10);
+}
+
+
+/**
+ * @brief Read the simulator's output until it closes it or the deadline passes.
+ *
+ * Lines longer than PERF_LINE_MAX are cut; only their start is scanned.
+ *
+ * @param fd Read end of the simulator's stdout.
+ * @param deadline Monotonic time in milliseconds after which to give up.
+ * @param run Run being measured.
+ * @return true if the output was read to the end, false on timeout.
+ */
+static bool drainRun(int fd, double deadline, t_run *run)
+{
+    struct pollfd   pfd;
+    char            buf[4096];
+    char            line[PERF_LINE_MAX];
+    size_t          len;
+    ssize_t         ret;
+    ssize_t         i;
+    double          left;
+
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    len = 0;
+    while (true)
+    {
+        left = deadline - nowIn_ms();
+        if (left <= 0)
+            return false;
+        if (poll(&pfd, 1, (int)left + 1) < 0 && errno != EINTR)
+            return false;
+        if (pfd.revents == 0)
+            continue;
+        ret = read(fd, buf, sizeof(buf));
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            return true;
+        i = -1;
+        while (++i < ret)
+        {
+            if (buf[i] != '\n')
+            {
+                if (len < sizeof(line) - 1)
+                    line[len++] = buf[i];
+                continue;
+            }
+            line[len] = '\0';
+            scanLine(line, run);
+            len = 0;
+        }
+    }
+}
+
+
+/**
+ * @brief Run the simulator once on a configuration and measure it.
+ *
+ * The configuration is split on spaces and followed by output=deaths, so
+ * stdout carries only deaths and the end-of-run summary. CPU time and
+ * context switches come from wait4()'s resource usage of the child; a run
+ * that outlives PERF_TIMEOUT_MS is killed and flagged.
+ *
+ * @param philo Path to the simulator.
+ * @param config Space-separated simulator arguments.
+ * @param run Receives the measurements.
+ * @return true if the simulator could be started, false otherwise.
+ */
+static bool measureRun(const char *philo, const char *config, t_run *run)
+{
+    char            args[PERF_LINE_MAX];
+    char            *argv[PERF_ARGS_MAX];
+    struct rusage   ru;
+    double          start;
+    pid_t           pid;
+    int             fds[2];
+    int             status;
+    int             n;
+
+    snprintf(args, sizeof(args), "%s", config);
+    n = 0;
+    argv[n++] = (char *)philo;
+    argv[n] = strtok(args, " ");
+    while (argv[n] && n < PERF_ARGS_MAX - 3)
+        argv[++n] = strtok(NULL, " ");
+    argv[n++] = "output=deaths";
+    argv[n] = NULL;
+    memset(run, 0, sizeof(t_run));
+    if (pipe(fds) != 0)
+        return false;
+    start = nowIn_ms();
+    pid = fork();
+    if (pid < 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0)
+    {
+        close(fds[0]);
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[1]);
+        execv(philo, argv);
+        _exit(127);
+    }
+    close(fds[1]);
+    if (!drainRun(fds[0], start + PERF_TIMEOUT_MS, run))
+    {
+        run->timed_out = true;
+        kill(pid, SIGKILL);
+    }
+    close(fds[0]);
+    while (wait4(pid, &status, 0, &ru) < 0 && errno == EINTR)
+        continue;
+    run->wall_ms = nowIn_ms() - start;
+    run->cpu_ms = ru.ru_utime.tv_sec * 1000.0 + ru.ru_utime.tv_usec / 1000.0
+        + ru.ru_stime.tv_sec * 1000.0 + ru.ru_stime.tv_usec / 1000.0;
+    run->ctxsw = (double)(ru.ru_nvcsw + ru.ru_nivcsw);
+    return !(WIFEXITED(status) && WEXITSTATUS(status) == 127);
+}
+
+
+/**
+ * @brief Sort helper for doubles, ascending.
+ *
+ * @param a Pointer to the first value.
+ * @param b Pointer to the second value.
+ * @return Negative, zero or positive as a is below, equal to or above b.
+ */
+static int compareDoubles(const void *a, const void *b)
+{
+    double  x;
+    double  y;
+
+    x = *(const double *)a;
+    y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+
+/**
+ * @brief Median of n values; the array is reordered.
+ *
+ * @param v Values.
+ * @param n Number of values, at least 1.
+ * @return Median value.
+ */
+static double median(double *v, int n)
+{
+    qsort(v, n, sizeof(double), compareDoubles);
+    if (n % 2)
+        return v[n / 2];
+    return (v[n / 2 - 1] + v[n / 2]) / 2.0;
+}
+
+
+/**
+ * @brief Run a configuration PERF_RUNS times and reduce it to metrics.
+ *
+ * Timings and throughput are medians over the runs, so one noisy run does
+ * not decide the outcome; deaths and timeouts count the runs affected.
+ *
+ * @param philo Path to the simulator.
+ * @param config Space-separated simulator arguments.
+ * @param out Receives one value per metric.
+ * @return true if every run could be started, false otherwise.
+ */
+static bool measureConfig(const char *philo, const char *config, double *out)
+{
+    t_run   run;
+    double  samples[M_MEALS_PER_S + 1][PERF_RUNS];
+    int     r;
+    int     m;
+
+    out[M_DEATHS] = 0;
+    out[M_TIMEOUTS] = 0;
+    r = -1;
+    while (++r < PERF_RUNS)
+    {
+        if (!measureRun(philo, config, &run))
+            return false;
+        samples[M_WALL][r] = run.wall_ms;
+        samples[M_CPU][r] = run.cpu_ms;
+        samples[M_CTXSW][r] = run.ctxsw;
+        samples[M_MEALS_PER_S][r] = run.meals / (run.wall_ms / 1000.0);
+        out[M_DEATHS] += run.died;
+        out[M_TIMEOUTS] += run.timed_out;
+    }
+    m = -1;
+    while (++m <= M_MEALS_PER_S)
+        out[m] = median(samples[m], PERF_RUNS);
+    return true;
+}
+
+
+/**
+ * @brief Look up a configuration's metrics in the baseline file.
+ *
+ * Each line is the configuration followed by tab-separated name=value
+ * pairs, as written by writeBaseline().
+ *
+ * @param path Baseline file.
+ * @param config Configuration to look up.
+ * @param out Receives one value per metric.
+ * @return true if every metric was found, false otherwise.
+ */
+static bool readBaseline(const char *path, const char *config, double *out)
+{
+    FILE    *file;
+    char    line[PERF_LINE_MAX];
+    char    *field;
+    size_t  klen;
+    int     found;
+    int     m;
+
+    file = fopen(path, "r");
+    if (!file)
+        return false;
+    found = 0;
+    while (fgets(line, sizeof(line), file))
+    {
+        line[strcspn(line, "\n")] = '\0';
+        field = strchr(line, '\t');
+        if (!field || (size_t)(field - line) != strlen(config)
+            || strncmp(line, config, field - line) != 0)
+            continue;
+        while (field)
+        {
+            field++;
+            m = -1;
+            while (++m < M_COUNT)
+            {
+                klen = strlen(g_limits[m].name);
+                if (strncmp(field, g_limits[m].name, klen) == 0 && field[klen] == '=')
+                {
+                    out[m] = strtod(field + klen + 1, NULL);
+                    found |= 1 << m;
+                }
+            }
+            field = strchr(field, '\t');
+        }
+        break;
+    }
+    fclose(file);
+    return found == (1 << M_COUNT) - 1;
+}
+
+
+/**
+ * @brief Read the CPU count the baseline was measured with.
+ *
+ * @param path Baseline file.
+ * @return The recorded count, or 0 if there is none.
+ */
+static long readBaselineCpus(const char *path)
+{
+    FILE    *file;
+    char    line[PERF_LINE_MAX];
+    long    cpus;
+
+    file = fopen(path, "r");
+    if (!file)
+        return 0;
+    cpus = 0;
+    while (fgets(line, sizeof(line), file))
+    {
+        if (strncmp(line, "# cpus=", 7) == 0)
+        {
+            cpus = strtol(line + 7, NULL, 10);
+            break;
+        }
+    }
+    fclose(file);
+    return cpus;
+}
+
+
+/**
+ * @brief Write every configuration's metrics as the new baseline.
+ *
+ * The first line records the CPU count of the machine: the numbers only
+ * mean something on the machine they were measured on.
+ *
+ * @param path Baseline file.
+ * @param results One row of metrics per configuration.
+ * @return true on success, false otherwise.
+ */
+static bool writeBaseline(const char *path, double results[][M_COUNT])
+{
+    FILE    *file;
+    int     c;
+    int     m;
+
+    file = fopen(path, "w");
+    if (!file)
+        return false;
+    fprintf(file, "# cpus=%ld\n", sysconf(_SC_NPROCESSORS_ONLN));
+    c = -1;
+    while (++c < PERF_CONFIGS)
+    {
+        fprintf(file, "%s", g_configs[c]);
+        m = -1;
+        while (++m < M_COUNT)
+            fprintf(file, "\t%s=%.1f", g_limits[m].name, results[c][m]);
+        fprintf(file, "\n");
+    }
+    return fclose(file) == 0;
+}
+
+
+/**
+ * @brief Compare a configuration's metrics with its baseline and print them.
+ *
+ * Metrics that are not gated for this configuration are printed as
+ * "ungated" and never count as regressions.
+ *
+ * @param config Configuration measured.
+ * @param now Metrics just measured.
+ * @param base Baseline metrics.
+ * @return Number of metrics that regressed past their limit.
+ */
+static int compareConfig(const char *config, double *now, double *base)
+{
+    const t_limit   *lim;
+    double          bound;
+    bool            gated;
+    bool            bad;
+    int             regressions;
+    int             m;
+
+    regressions = 0;
+    m = -1;
+    while (++m < M_COUNT)
+    {
+        lim = &g_limits[m];
+        gated = m != M_MEALS_PER_S || base[M_DEATHS] == 0;
+        bound = base[m] * lim->ratio + (lim->higher_is_worse ? lim->slack : -lim->slack);
+        bad = gated && (lim->higher_is_worse ? now[m] > bound : now[m] < bound);
+        regressions += bad;
+        printf("PERF\t%s\t%s\tbase=%.1f\tnow=%.1f\tdelta=%+.1f%%\t%s\n",
+            config, lim->name, base[m], now[m],
+            base[m] != 0 ? (now[m] - base[m]) / base[m] * 100.0 : 0.0,
+            !gated ? "ungated" : bad ? "REGRESSED" : "ok");
+    }
+    return regressions;
+}
+
+
+/**
+ * @brief Check that a new baseline has no run that died or hung.
+ *
+ * @param results One row of metrics per configuration.
+ * @return true if every run finished, false otherwise (the configurations
+ *         at fault are printed).
+ */
+static bool isCleanBaseline(double results[][M_COUNT])
+{
+    bool    clean;
+    int     c;
+
+    clean = true;
+    c = -1;
+    while (++c < PERF_CONFIGS)
+    {
+        if (results[c][M_DEATHS] == 0 && results[c][M_TIMEOUTS] == 0)
+            continue;
+        fprintf(stderr, "PERF\t%s\t%.0f death(s), %.0f timeout(s); not a baseline\n",
+            g_configs[c], results[c][M_DEATHS], results[c][M_TIMEOUTS]);
+        clean = false;
+    }
+    return clean;
+}
+
+
+/**
+ * @brief Regression benchmark for the simulator.
+ *
+ * Runs every configuration PERF_RUNS times and either records the results
+ * as the new baseline (--update) or compares them against it, failing if
+ * any metric regressed past its limit. Configurations missing from the
+ * baseline are reported but do not fail the run. A baseline in which any
+ * run died or hung is refused. Baselines are machine-specific: comparing
+ * against one measured with a different CPU count prints a warning.
+ *
+ * Usage: perf <philo binary> <baseline file> [--update]
+ *
+ * @param ac Argument count.
+ * @param av Argument vector.
+ * @return EXIT_SUCCESS if nothing regressed, EXIT_FAILURE otherwise.
+ */
+int main(int ac, char **av)
+{
+    double  results[PERF_CONFIGS][M_COUNT];
+    double  base[M_COUNT];
+    long    cpus;
+    bool    update;
+    int     regressions;
+    int     c;
+
+    update = ac == 4 && strcmp(av[3], "--update") == 0;
+    if (ac != 3 && !update)
+    {
+        fprintf(stderr, "Usage: %s <philo binary> <baseline file> [--update]\n", av[0]);
+        return EXIT_FAILURE;
+    }
+    cpus = readBaselineCpus(av[2]);
+    if (!update && cpus != sysconf(_SC_NPROCESSORS_ONLN))
+        fprintf(stderr, "PERF\tbaseline measured on %ld CPU(s), this machine has %ld;"
+            " rerun make perf_baseline here\n", cpus, sysconf(_SC_NPROCESSORS_ONLN));
+    regressions = 0;
+    c = -1;
+    while (++c < PERF_CONFIGS)
+    {
+        if (!measureConfig(av[1], g_configs[c], results[c]))
+        {
+            fprintf(stderr, "Cannot run %s.\n", av[1]);
+            return EXIT_FAILURE;
+        }
+        if (update)
+            continue;
+        if (!readBaseline(av[2], g_configs[c], base))
+            printf("PERF\t%s\tno baseline\n", g_configs[c]);
+        else
+            regressions += compareConfig(g_configs[c], results[c], base);
+    }
+    if (update && !isCleanBaseline(results))
+        return EXIT_FAILURE;
+    if (update && !writeBaseline(av[2], results))
+    {
+        fprintf(stderr, "Cannot write %s.\n", av[2]);
+        return EXIT_FAILURE;
+    }
+    if (update)
+        printf("PERF\tbaseline written to %s\n", av[2]);
+    else
+        printf("PERF\t%d regression(s)\n", regressions);
+    return regressions ? EXIT_FAILURE : EXIT_SUCCESS;
+}